@@ -0,0 +1,400 @@
+#include "approximate-counter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+ApproximateCounter::ApproximateCounter(const StructType& type, const ApproximationOptions& options)
+	: type(&type), options(options), generator(options.seed)
+{
+	assert(type.isPreprocessed());
+	assert(options.tolerance > 0 && options.confidence > 0 && options.confidence < 1);
+}
+
+double ApproximateCounter::count()
+{
+	return count(PartialAssignment(type->getDeepPropertyDistinctCount()));
+}
+
+double ApproximateCounter::count(const PartialAssignment& assumptions)
+{
+	assert(assumptions.getVariableCount() == type->getDeepPropertyDistinctCount());
+	vec<Term> terms;
+	collectTerms(*type, assumptions, terms);
+	// the terms are estimated independently, so the failure probability is split among them;
+	// the sum of estimates within the tolerance of their counts is within the tolerance of the total
+	double total = 0;
+	for (const Term& term : terms)
+		total += estimate(term, (1 - options.confidence) / terms.size());
+	return total;
+}
+
+void ApproximateCounter::collectTerms(const StructType& countedType, PartialAssignment assumptions, vec<Term>& terms) const
+{
+	for (const Promotion& promotion : countedType.getPromotions())
+	{
+		if (assumptions.isSpecified(promotion.property))
+			continue;
+		PartialAssignment projected;
+		const bool consistent = promotion.project(assumptions, projected);
+		if (consistent)
+			collectTerms(*promotion.target, projected, terms);
+		assumptions.set(promotion.property, false);
+	}
+	terms.push_back({ &countedType, assumptions });
+}
+
+double ApproximateCounter::estimate(const Term& term, const double failureProbability)
+{
+	load(*term.type);
+	const double tolerance = options.tolerance;
+	const size_t threshold = std::ceil(1 + 9.84 * (1 + tolerance / (1 + tolerance)) * (1 + 1 / tolerance) * (1 + 1 / tolerance));
+
+	// few instances are counted exactly
+	CountingOptions residualOptions;
+	residualOptions.decisionLimit = threshold;
+	residualCounter = make_unique<InstanceCounter>(*term.type, residualOptions);
+	setRowCount(0);
+	if (!assume(term.assumptions))
+		return 0;
+	const size_t exact = countBounded(threshold, 0);
+	if (exact < threshold)
+		return exact;
+
+	// every iteration makes at least one bounded count of up to the threshold instances, so the exact count is tried first
+	// with as many decisions as the iterations would take at the least; the components and the cache often finish it much sooner
+	const uint32_t iterations = std::ceil(17 * std::log2(3 / failureProbability));
+	CountingOptions countingOptions;
+	countingOptions.decisionLimit = size_t(iterations) * threshold;
+	InstanceCounter exactCounter(*term.type, countingOptions);
+	const size_t exactCount = exactCounter.count(term.assumptions);
+	if (!exactCounter.isStopped())
+		return exactCount;
+
+	// a hash that keeps a cell at the threshold with all its rows gives no estimate, so it is retried with a fresh one,
+	// up to as many times as there are iterations
+	vec<double> estimates;
+	uint32_t previousRowCount = 1;
+	for (uint32_t attempt = 0; estimates.size() < iterations && attempt < 2 * iterations; attempt++)
+	{
+		drawRows();
+		// the hashes with more rows are prefixes of each other, so the cell counts only decrease with the row count;
+		// the first row count with a cell below the threshold is searched for by galloping from the one found by the previous hash,
+		// as the counts found by the independent hashes are close, and then by bisection
+		// (low always has a cell at the threshold, high is past the rows or has a cell below it)
+		const auto& countCell = [&](const uint32_t rowCount)
+		{
+			setRowCount(rowCount);
+			return assume(term.assumptions) ? countBounded(threshold, 0) : 0;
+		};
+		uint32_t low = 0;
+		uint32_t high = variableCount + 1;
+		size_t cellCount = 0;
+		const uint32_t start = std::clamp(previousRowCount, uint32_t(1), variableCount);
+		uint32_t step = 1;
+		const size_t startCell = countCell(start);
+		if (startCell < threshold)
+		{
+			high = start;
+			cellCount = startCell;
+			while (high - low > step)
+			{
+				const size_t cell = countCell(high - step);
+				if (cell >= threshold)
+				{
+					low = high - step;
+					break;
+				}
+				high -= step;
+				cellCount = cell;
+				step *= 2;
+			}
+		}
+		else
+		{
+			low = start;
+			while (high - low > step)
+			{
+				const size_t cell = countCell(low + step);
+				if (cell < threshold)
+				{
+					high = low + step;
+					cellCount = cell;
+					break;
+				}
+				low += step;
+				step *= 2;
+			}
+		}
+		while (high - low > 1)
+		{
+			const uint32_t middle = (low + high) / 2;
+			const size_t cell = countCell(middle);
+			if (cell < threshold)
+			{
+				high = middle;
+				cellCount = cell;
+			}
+			else
+				low = middle;
+		}
+		if (high <= variableCount)
+		{
+			estimates.push_back(std::ldexp(double(cellCount), high));
+			previousRowCount = high;
+		}
+	}
+	if (estimates.empty())
+		return std::numeric_limits<double>::quiet_NaN();
+	std::sort(estimates.begin(), estimates.end());
+	return estimates[estimates.size() / 2];
+}
+
+void ApproximateCounter::load(const StructType& countedType)
+{
+	variableCount = countedType.getDeepPropertyDistinctCount();
+	propagator.load(countedType.flatRelations, variableCount);
+	rowCount = 0;
+	rowWordCount = (variableCount + 1 + 63) / 64;
+	rows.clear();
+	consistentRows = true;
+	echelon = Echelon();
+	// every level of the search assigns a property, so there are at most as many levels as properties
+	savedEchelons.resize(variableCount + 1);
+}
+
+void ApproximateCounter::drawRows()
+{
+	// the rows are refilled in place, so the hashes of the iterations reuse their storage
+	propagator.undo(0);
+	rowCount = 0;
+	rows.assign(size_t(variableCount) * rowWordCount, 0);
+	for (uint32_t ri = 0; ri < variableCount; ri++)
+	{
+		uint64_t* row = &rows[size_t(ri) * rowWordCount];
+		// the parity follows the properties
+		for (uint32_t variable = 0; variable <= variableCount; variable++)
+		{
+			if (generator() & 1)
+				row[variable >> 6] |= uint64_t(1) << (variable & 63);
+		}
+	}
+}
+
+void ApproximateCounter::setRowCount(const uint32_t count)
+{
+	// the trail is empty whenever the row count changes, so the active rows are reduced from scratch
+	propagator.undo(0);
+	rowCount = count;
+	consistentRows = true;
+	echelon.rows.clear();
+	echelon.pivots.clear();
+	echelon.rowHead = 0;
+	for (uint32_t ri = 0; ri < rowCount; ri++)
+	{
+		const uint32_t reducedIndex = echelon.pivots.size();
+		echelon.rows.insert(echelon.rows.end(), rows.begin() + size_t(ri) * rowWordCount, rows.begin() + size_t(ri + 1) * rowWordCount);
+		uint64_t* row = &echelon.rows[size_t(reducedIndex) * rowWordCount];
+		for (uint32_t pi = 0; pi < reducedIndex; pi++)
+		{
+			const uint32_t pivot = echelon.pivots[pi];
+			if (row[pivot >> 6] & (uint64_t(1) << (pivot & 63)))
+			{
+				const uint64_t* pivotRow = &echelon.rows[size_t(pi) * rowWordCount];
+				for (uint32_t wi = 0; wi < rowWordCount; wi++)
+					row[wi] ^= pivotRow[wi];
+			}
+		}
+		const uint32_t pivot = findRowVariable(row, ClausePropagator::NoVariable);
+		if (pivot == ClausePropagator::NoVariable)
+		{
+			// a row dependent on the previous ones must agree with their parities
+			if ((row[variableCount >> 6] >> (variableCount & 63)) & 1)
+				consistentRows = false;
+			echelon.rows.resize(size_t(reducedIndex) * rowWordCount);
+			continue;
+		}
+		echelon.pivots.push_back(pivot);
+		eliminatePivot(reducedIndex);
+	}
+}
+
+bool ApproximateCounter::assume(const PartialAssignment& assumptions)
+{
+	return consistentRows && propagator.assume(assumptions) && propagate();
+}
+
+bool ApproximateCounter::propagate()
+{
+	// the clauses are propagated to a fixed point, then the new assignments are eliminated from the rows, which may assign more
+	const vec<uint32_t>& trail = propagator.getTrail();
+	while (propagator.propagate())
+	{
+		if (echelon.rowHead == trail.size())
+			return true;
+		while (echelon.rowHead < trail.size())
+		{
+			const uint32_t variable = trail[echelon.rowHead++];
+			if (!eliminate(variable, propagator.getValue(variable)))
+				return false;
+		}
+	}
+	return false;
+}
+
+bool ApproximateCounter::eliminate(const uint32_t variable, const bool value)
+{
+	const uint32_t word = variable >> 6;
+	const uint64_t bit = uint64_t(1) << (variable & 63);
+	const uint32_t parityWord = variableCount >> 6;
+	const uint64_t parityBit = uint64_t(1) << (variableCount & 63);
+	bool found = false;
+	uint32_t pivotIndex = 0;
+	for (uint32_t ri = 0; ri < echelon.pivots.size(); ri++)
+	{
+		uint64_t* row = &echelon.rows[size_t(ri) * rowWordCount];
+		if (!(row[word] & bit))
+			continue;
+		found = true;
+		row[word] &= ~bit;
+		if (value)
+			row[parityWord] ^= parityBit;
+		if (echelon.pivots[ri] == variable)
+			pivotIndex = ri;
+	}
+	if (!found)
+		return true;
+	if (echelon.pivots[pivotIndex] == variable)
+	{
+		// the row that lost its pivot takes another of its properties, or it is dropped when it has none left
+		uint64_t* row = &echelon.rows[size_t(pivotIndex) * rowWordCount];
+		const uint32_t pivot = findRowVariable(row, ClausePropagator::NoVariable);
+		if (pivot == ClausePropagator::NoVariable)
+		{
+			if (row[parityWord] & parityBit)
+				return false;
+			const uint32_t lastIndex = echelon.pivots.size() - 1;
+			std::copy_n(&echelon.rows[size_t(lastIndex) * rowWordCount], rowWordCount, row);
+			echelon.pivots[pivotIndex] = echelon.pivots[lastIndex];
+			echelon.pivots.pop_back();
+			echelon.rows.resize(size_t(lastIndex) * rowWordCount);
+		}
+		else
+		{
+			echelon.pivots[pivotIndex] = pivot;
+			eliminatePivot(pivotIndex);
+		}
+	}
+	// the rows left with their pivot alone fix it; a pivot assigned already is only not yet eliminated, which checks its row
+	for (uint32_t ri = 0; ri < echelon.pivots.size(); ri++)
+	{
+		const uint32_t pivot = echelon.pivots[ri];
+		const uint64_t* row = &echelon.rows[size_t(ri) * rowWordCount];
+		if (propagator.getValue(pivot) == ClausePropagator::Unset && findRowVariable(row, pivot) == ClausePropagator::NoVariable)
+			propagator.assign(pivot, row[parityWord] & parityBit);
+	}
+	return true;
+}
+
+void ApproximateCounter::eliminatePivot(const uint32_t ri)
+{
+	const uint32_t pivot = echelon.pivots[ri];
+	const uint64_t* pivotRow = &echelon.rows[size_t(ri) * rowWordCount];
+	for (uint32_t other = 0; other < echelon.pivots.size(); other++)
+	{
+		uint64_t* row = &echelon.rows[size_t(other) * rowWordCount];
+		if (other != ri && (row[pivot >> 6] & (uint64_t(1) << (pivot & 63))))
+		{
+			for (uint32_t wi = 0; wi < rowWordCount; wi++)
+				row[wi] ^= pivotRow[wi];
+		}
+	}
+}
+
+uint32_t ApproximateCounter::countRowVariables(const uint64_t* row) const
+{
+	uint32_t count = 0;
+	for (uint32_t wi = 0; wi < rowWordCount; wi++)
+		count += __builtin_popcountll(row[wi]);
+	return count - ((row[variableCount >> 6] >> (variableCount & 63)) & 1);
+}
+
+uint32_t ApproximateCounter::findRowVariable(const uint64_t* row, const uint32_t skipped) const
+{
+	for (uint32_t wi = 0; wi < rowWordCount; wi++)
+	{
+		uint64_t word = row[wi];
+		if (wi == variableCount >> 6)
+			word &= ~(uint64_t(1) << (variableCount & 63));
+		if (wi == skipped >> 6)
+			word &= ~(uint64_t(1) << (skipped & 63));
+		if (word)
+			return wi * 64 + __builtin_ctzll(word);
+	}
+	return ClausePropagator::NoVariable;
+}
+
+uint32_t ApproximateCounter::pickRowVariable() const
+{
+	// the row with the fewest properties is the closest to fixing them, and after the propagation every row has two at least
+	uint32_t bestIndex = 0;
+	uint32_t bestCount = std::numeric_limits<uint32_t>::max();
+	for (uint32_t ri = 0; ri < echelon.pivots.size(); ri++)
+	{
+		const uint32_t count = countRowVariables(&echelon.rows[size_t(ri) * rowWordCount]);
+		if (count < bestCount)
+		{
+			bestIndex = ri;
+			bestCount = count;
+		}
+	}
+	return findRowVariable(&echelon.rows[size_t(bestIndex) * rowWordCount], echelon.pivots[bestIndex]);
+}
+
+size_t ApproximateCounter::countBounded(const size_t limit, const uint32_t depth)
+{
+	// counts the solutions of the clauses and the rows under the current assignment, but at most limit of them;
+	// the search branches on the properties of the rows first, once the clauses are satisfied the rows left are a consistent
+	// linear system counted by its rank, and once the rows are all eliminated the residual clauses are counted exactly
+	const vec<uint32_t>& trail = propagator.getTrail();
+	const uint32_t trailSize = trail.size();
+	savedEchelons[depth] = echelon;
+	size_t result = 0;
+	if (propagate())
+	{
+		const uint32_t freeCount = variableCount - trail.size() - echelon.pivots.size();
+		if (propagator.areClausesSatisfied())
+			result = freeCount >= 64 || (size_t(1) << freeCount) >= limit ? limit : size_t(1) << freeCount;
+		else if (!echelon.pivots.empty() || !countResidual(limit, result))
+		{
+			const uint32_t variable = echelon.pivots.empty() ? propagator.pickBranchVariable() : pickRowVariable();
+			const uint32_t branchTrailSize = trail.size();
+			for (const bool value : { false, true })
+			{
+				if (result >= limit)
+					break;
+				propagator.assign(variable, value);
+				// the level below restores the echelon form without the branch assignment
+				result += countBounded(limit - result, depth + 1);
+				propagator.undo(branchTrailSize);
+			}
+		}
+	}
+	propagator.undo(trailSize);
+	echelon = savedEchelons[depth];
+	return std::min(result, limit);
+}
+
+bool ApproximateCounter::countResidual(const size_t limit, size_t& result)
+{
+	// the counter brings its components and its cache, the counts that take too many decisions are left to the search
+	PartialAssignment assignment(variableCount);
+	for (const uint32_t variable : propagator.getTrail())
+		assignment.set(variable, propagator.getValue(variable));
+	const size_t count = residualCounter->count(assignment);
+	if (residualCounter->isStopped())
+		return false;
+	result = std::min(count, limit);
+	return true;
+}
\ No newline at end of file
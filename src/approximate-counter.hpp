@@ -0,0 +1,92 @@
+#pragma once
+
+#include <random>
+
+#include "clause-propagator.hpp"
+#include "instance-counter.hpp"
+#include "partial-assignment.hpp"
+#include "ptr.hpp"
+#include "struct-type.hpp"
+#include "vec.hpp"
+
+struct ApproximationOptions
+{
+	// the estimate is within the factor (1 + tolerance) of the count with at least the given probability
+	double tolerance = 0.1;
+	double confidence = 0.9;
+	uint64_t seed = 1;
+};
+
+// Estimates the instance counts of a preprocessed type in the style of ApproxMC.
+// Random XOR constraints over the deep properties split the instances into cells, the instances of one cell
+// are counted exactly up to a threshold and the median of the scaled cell counts over independent hashes is the estimate.
+// The promotion chain is expanded as in the exact counter and every type in it is estimated separately.
+class ApproximateCounter
+{
+public:
+	ApproximateCounter(const StructType& type, const ApproximationOptions& options = ApproximationOptions());
+
+	// the estimates are NaN when a hash keeps a cell at the threshold with all its rows, even after the retries with fresh hashes
+	double count();
+	double count(const PartialAssignment& assumptions);
+
+private:
+	struct Term
+	{
+		const StructType* type;
+		PartialAssignment assumptions;
+	};
+
+	const StructType* type;
+	ApproximationOptions options;
+	std::mt19937_64 generator;
+
+	// the search over the type that is being estimated
+	uint32_t variableCount = 0;
+	ClausePropagator propagator;
+
+	// the XOR constraints of the current hash as bitsets over the properties followed by their parities, each says that the sum
+	// of its properties is its parity; the hashes with fewer rows are the prefixes of the rows, only the first rowCount are active
+	uint32_t rowCount = 0;
+	uint32_t rowWordCount = 0;
+	vec<uint64_t> rows;
+	bool consistentRows = true;
+
+	// the active rows with the assignments of the trail before the row head eliminated, in reduced row echelon form:
+	// every row has a pivot property that the other rows do not have, and the rows reduced to zero are dropped
+	struct Echelon
+	{
+		vec<uint64_t> rows;
+		vec<uint32_t> pivots;
+		uint32_t rowHead = 0;
+	};
+	Echelon echelon;
+	// the echelon forms at the start of the levels of the bounded search, restored when they undo their assignments
+	vec<Echelon> savedEchelons;
+
+	// counts the instances once the rows are eliminated, with a decision limit of the threshold
+	uptr<InstanceCounter> residualCounter;
+
+	void collectTerms(const StructType& type, PartialAssignment assumptions, vec<Term>& terms) const;
+	double estimate(const Term& term, double failureProbability);
+
+	void load(const StructType& type);
+	// draws the rows of a new hash, all inactive
+	void drawRows();
+	void setRowCount(uint32_t count);
+	bool assume(const PartialAssignment& assumptions);
+
+	// propagates the clauses and the rows to a fixed point, returns false on a conflict
+	bool propagate();
+	// eliminates an assignment from the rows and assigns the properties of the rows it leaves with a single one
+	bool eliminate(uint32_t variable, bool value);
+	// eliminates the pivot of a row from the other rows
+	void eliminatePivot(uint32_t ri);
+	// the number of properties of a row, and the first one besides the skipped one or NoVariable
+	uint32_t countRowVariables(const uint64_t* row) const;
+	uint32_t findRowVariable(const uint64_t* row, uint32_t skipped) const;
+	// a property of the row with the fewest properties that is not its pivot
+	uint32_t pickRowVariable() const;
+	size_t countBounded(size_t limit, uint32_t depth);
+	bool countResidual(size_t limit, size_t& result);
+};
\ No newline at end of file
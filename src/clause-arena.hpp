@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "vec.hpp"
+
+// Clauses stored in compressed sparse rows: the literals of all the clauses in a single array, encoded as (index << 1 | negated),
+// and the start of every clause in another, so that a clause takes 4 bytes per literal and 4 bytes of offset
+// and the clauses are scanned in the order they are stored in memory.
+class ClauseArena
+{
+public:
+	// the literals of a stored clause, valid until a clause is added
+	class Clause
+	{
+	public:
+		Clause(const uint32_t* first, const uint32_t* last) : first(first), last(last)
+		{
+		}
+
+		const uint32_t* begin() const
+		{
+			return first;
+		}
+
+		const uint32_t* end() const
+		{
+			return last;
+		}
+
+		uint32_t size() const
+		{
+			return last - first;
+		}
+
+		bool empty() const
+		{
+			return first == last;
+		}
+
+		uint32_t operator[](const uint32_t i) const
+		{
+			return first[i];
+		}
+
+		uint32_t front() const
+		{
+			return *first;
+		}
+
+		uint32_t back() const
+		{
+			return last[-1];
+		}
+
+	private:
+		const uint32_t* first;
+		const uint32_t* last;
+	};
+
+	ClauseArena() : starts(1, 0)
+	{
+	}
+
+	uint32_t getClauseCount() const
+	{
+		return mappedStarts ? mappedClauseCount : starts.size() - 1;
+	}
+
+	size_t getLiteralCount() const
+	{
+		return getStarts()[getClauseCount()];
+	}
+
+	Clause operator[](const uint32_t clause) const
+	{
+		const uint32_t* const clauseStarts = getStarts();
+		return Clause(getLiterals() + clauseStarts[clause], getLiterals() + clauseStarts[clause + 1]);
+	}
+
+	// the clauses are built by adding their literals and closing them
+	void addLiteral(const uint32_t literal)
+	{
+		assert(!mappedStarts);
+		literals.push_back(literal);
+	}
+
+	void endClause()
+	{
+		assert(!mappedStarts);
+		starts.push_back(literals.size());
+	}
+
+	void reserve(const size_t clauseCount, const size_t literalCount)
+	{
+		starts.reserve(clauseCount + 1);
+		literals.reserve(literalCount);
+	}
+
+	void clear()
+	{
+		literals.clear();
+		starts.assign(1, 0);
+		mappedLiterals = nullptr;
+		mappedStarts = nullptr;
+	}
+
+	// refers to clauses stored elsewhere in the same layout, e.g. in a mapped file, instead of copying them;
+	// the words must outlive the arena and no clauses can be added to it
+	void view(const uint32_t* clauseStarts, const uint32_t clauseCount, const uint32_t* clauseLiterals)
+	{
+		clear();
+		mappedStarts = clauseStarts;
+		mappedClauseCount = clauseCount;
+		mappedLiterals = clauseLiterals;
+	}
+
+	// the literals of all the clauses and the starts of the clauses followed by the number of the literals
+	const uint32_t* getLiterals() const
+	{
+		return mappedStarts ? mappedLiterals : literals.data();
+	}
+
+	const uint32_t* getStarts() const
+	{
+		return mappedStarts ? mappedStarts : starts.data();
+	}
+
+private:
+	vec<uint32_t> literals;
+	vec<uint32_t> starts;
+	// the viewed clauses, if mappedStarts is set
+	const uint32_t* mappedLiterals = nullptr;
+	const uint32_t* mappedStarts = nullptr;
+	uint32_t mappedClauseCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "clause-propagator.hpp"
+
+#include <algorithm>
+
+void ClausePropagator::load(const ClauseArena& relations, const uint32_t variableCount)
+{
+	this->variableCount = variableCount;
+	clauseCount = relations.getClauseCount();
+	clauseLiterals = relations.getLiterals();
+	clauseStarts = relations.getStarts();
+	hasEmptyClause = false;
+	occurrences.assign(variableCount * 2, {});
+	for (uint32_t clause = 0; clause < clauseCount; clause++)
+	{
+		if (clauseStarts[clause] == clauseStarts[clause + 1])
+			hasEmptyClause = true;
+		for (uint32_t li = clauseStarts[clause]; li < clauseStarts[clause + 1]; li++)
+			occurrences[clauseLiterals[li]].push_back(clause);
+	}
+	trueCounts.assign(clauseCount, 0);
+	satisfiedCount = 0;
+	values.assign(variableCount, Unset);
+	trail.clear();
+	trail.reserve(variableCount);
+	propagationHead = 0;
+}
+
+bool ClausePropagator::assume(const PartialAssignment& assumptions)
+{
+	if (hasEmptyClause)
+		return false;
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		if (!assumptions.isSpecified(variable))
+			continue;
+		if (values[variable] != Unset)
+		{
+			if (values[variable] != assumptions.getValue(variable))
+				return false;
+			continue;
+		}
+		assign(variable, assumptions.getValue(variable));
+		if (!propagate())
+			return false;
+	}
+	// the unit clauses are never visited by a propagation, so they are assigned here
+	for (uint32_t clause = 0; clause < clauseCount; clause++)
+	{
+		if (clauseStarts[clause + 1] - clauseStarts[clause] != 1)
+			continue;
+		const uint32_t literal = clauseLiterals[clauseStarts[clause]];
+		if (values[literal >> 1] == (literal & 1))
+			return false;
+		if (values[literal >> 1] == Unset)
+		{
+			assign(literal >> 1, !(literal & 1));
+			if (!propagate())
+				return false;
+		}
+	}
+	return true;
+}
+
+void ClausePropagator::assign(const uint32_t variable, const bool value)
+{
+	values[variable] = value;
+	trail.push_back(variable);
+	for (const uint32_t clause : occurrences[variable << 1 | !value])
+		satisfiedCount += trueCounts[clause]++ == 0;
+}
+
+void ClausePropagator::undo(const uint32_t trailSize)
+{
+	while (trail.size() > trailSize)
+	{
+		const uint32_t variable = trail.back();
+		for (const uint32_t clause : occurrences[variable << 1 | !values[variable]])
+			satisfiedCount -= --trueCounts[clause] == 0;
+		values[variable] = Unset;
+		trail.pop_back();
+	}
+	propagationHead = std::min(propagationHead, trailSize);
+}
+
+bool ClausePropagator::propagate()
+{
+	while (propagationHead < trail.size())
+	{
+		const uint32_t variable = trail[propagationHead++];
+		for (const uint32_t clause : occurrences[variable << 1 | values[variable]])
+		{
+			if (trueCounts[clause])
+				continue;
+			uint32_t unassigned = NoVariable;
+			uint32_t unassignedCount = 0;
+			for (uint32_t li = clauseStarts[clause]; li < clauseStarts[clause + 1] && unassignedCount < 2; li++)
+			{
+				if (values[clauseLiterals[li] >> 1] == Unset)
+				{
+					unassigned = clauseLiterals[li];
+					unassignedCount++;
+				}
+			}
+			if (unassignedCount == 0)
+				return false;
+			if (unassignedCount == 1)
+				assign(unassigned >> 1, !(unassigned & 1));
+		}
+	}
+	return true;
+}
+
+uint32_t ClausePropagator::pickBranchVariable() const
+{
+	if (areClausesSatisfied())
+		return NoVariable;
+	for (uint32_t clause = 0; clause < clauseCount; clause++)
+	{
+		if (trueCounts[clause])
+			continue;
+		for (uint32_t li = clauseStarts[clause]; li < clauseStarts[clause + 1]; li++)
+		{
+			if (values[clauseLiterals[li] >> 1] == Unset)
+				return clauseLiterals[li] >> 1;
+		}
+	}
+	return NoVariable;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "clause-arena.hpp"
+#include "partial-assignment.hpp"
+#include "vec.hpp"
+
+// The search state over the relations of a type shared by the enumerator and the approximate counter:
+// a single assignment with an undo trail, the clauses counted as satisfied by their true literals and propagated
+// when the assigned literals leave one of them unit. The relations are referred to, so they must outlive the loaded state.
+class ClausePropagator
+{
+public:
+	static constexpr uint32_t NoVariable = std::numeric_limits<uint32_t>::max();
+	static constexpr uint8_t Unset = 2;
+
+	// resets the state to the empty assignment over the variables of the relations
+	void load(const ClauseArena& relations, uint32_t variableCount);
+	// assigns the assumptions and the unit clauses and propagates them, returns false on a conflict
+	bool assume(const PartialAssignment& assumptions);
+
+	void assign(uint32_t variable, bool value);
+	void undo(uint32_t trailSize);
+	// propagates the assignments made since the last call, returns false on a conflict
+	bool propagate();
+	// the first unassigned variable of the first unsatisfied clause, or NoVariable if all the clauses are satisfied
+	uint32_t pickBranchVariable() const;
+
+	bool areClausesSatisfied() const
+	{
+		return satisfiedCount == clauseCount;
+	}
+
+	uint32_t getVariableCount() const
+	{
+		return variableCount;
+	}
+
+	// 0, 1 or Unset
+	uint8_t getValue(const uint32_t variable) const
+	{
+		return values[variable];
+	}
+
+	// the assigned variables in the order they were assigned
+	const vec<uint32_t>& getTrail() const
+	{
+		return trail;
+	}
+
+private:
+	// clause literals are encoded as (property index << 1 | negated)
+	uint32_t variableCount = 0;
+	uint32_t clauseCount = 0;
+	const uint32_t* clauseLiterals = nullptr;
+	const uint32_t* clauseStarts = nullptr;
+	vec<vec<uint32_t>> occurrences;
+	vec<uint32_t> trueCounts;
+	// the clauses with a true literal
+	uint32_t satisfiedCount = 0;
+	bool hasEmptyClause = false;
+
+	vec<uint8_t> values;
+	vec<uint32_t> trail;
+	uint32_t propagationHead = 0;
+};
\ No newline at end of file
@@ -0,0 +1,586 @@
+#include "clause-simplifier.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "struct-type.hpp"
+
+namespace
+{
+
+constexpr uint32_t NoLiteral = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t MaxRounds = 32;
+
+// sorts the literals and removes the duplicate ones, returns false if the clause is a tautology
+bool normalizeClause(vec<uint32_t>& literals)
+{
+	std::sort(literals.begin(), literals.end());
+	literals.erase(std::unique(literals.begin(), literals.end()), literals.end());
+	for (uint32_t i = 1; i < literals.size(); i++)
+	{
+		if ((literals[i - 1] ^ 1) == literals[i])
+			return false;
+	}
+	return true;
+}
+
+}
+
+SimplificationStats& SimplificationStats::operator+=(const SimplificationStats& other)
+{
+	clausesBefore += other.clausesBefore;
+	literalsBefore += other.literalsBefore;
+	clausesAfter += other.clausesAfter;
+	literalsAfter += other.literalsAfter;
+	subsumedClauses += other.subsumedClauses;
+	strengthenedClauses += other.strengthenedClauses;
+	failedLiterals += other.failedLiterals;
+	substitutedVariables += other.substitutedVariables;
+	eliminatedVariables += other.eliminatedVariables;
+	return *this;
+}
+
+ClauseSimplifier::ClauseSimplifier(const uint32_t variableCount, const SimplificationOptions& options)
+	: variableCount(variableCount), options(options), values(variableCount, Unset), substitutes(variableCount), eliminated(variableCount, false),
+	occurrences(variableCount * 2), marks(variableCount * 2, 0)
+{
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+		substitutes[variable] = variable << 1;
+}
+
+vec<vec<FlatProperty>> ClauseSimplifier::simplify(const vec<vec<FlatProperty>>& relations)
+{
+	for (const vec<FlatProperty>& relation : relations)
+	{
+		stats.clausesBefore++;
+		stats.literalsBefore += relation.size();
+		vec<uint32_t> literals;
+		literals.reserve(relation.size());
+		for (const FlatProperty& property : relation)
+			literals.push_back(property.index << 1 | property.negated);
+		addClause(std::move(literals));
+	}
+
+	// the cheaper steps are repeated until they change nothing before the more expensive ones run
+	bool changed = true;
+	for (uint32_t round = 0; changed && !unsatisfiable && round < MaxRounds; round++)
+	{
+		changed = false;
+		if (!propagateUnits())
+			break;
+		if (options.equivalences && substituteEquivalences())
+			changed = true;
+		else if (options.subsumption && subsume())
+			changed = true;
+		else if (options.probing && probe())
+			changed = true;
+		else if (options.eliminateDefined && eliminateDefined())
+			changed = true;
+	}
+	if (!unsatisfiable)
+		propagateUnits();
+	return buildResult();
+}
+
+const SimplificationStats& ClauseSimplifier::getStats() const
+{
+	return stats;
+}
+
+bool ClauseSimplifier::isTrue(const uint32_t literal) const
+{
+	return values[literal >> 1] != Unset && values[literal >> 1] != (literal & 1);
+}
+
+bool ClauseSimplifier::isFalse(const uint32_t literal) const
+{
+	return values[literal >> 1] == (literal & 1);
+}
+
+void ClauseSimplifier::assign(const uint32_t literal)
+{
+	values[literal >> 1] = !(literal & 1);
+}
+
+void ClauseSimplifier::addClause(vec<uint32_t> literals)
+{
+	if (!normalizeClause(literals))
+		return;
+	if (literals.empty())
+		unsatisfiable = true;
+	clauses.push_back(std::move(literals));
+	deleted.push_back(false);
+}
+
+void ClauseSimplifier::buildOccurrences()
+{
+	for (vec<uint32_t>& literalOccurrences : occurrences)
+		literalOccurrences.clear();
+	for (uint32_t ci = 0; ci < clauses.size(); ci++)
+	{
+		if (deleted[ci])
+			continue;
+		for (const uint32_t literal : clauses[ci])
+			occurrences[literal].push_back(ci);
+	}
+}
+
+bool ClauseSimplifier::propagateUnits()
+{
+	// assigns the unit clauses, then removes the satisfied clauses and the false literals, until no clause is unit
+	bool assigned = true;
+	while (assigned)
+	{
+		assigned = false;
+		for (uint32_t ci = 0; ci < clauses.size(); ci++)
+		{
+			if (deleted[ci])
+				continue;
+			vec<uint32_t>& clause = clauses[ci];
+			bool satisfied = false;
+			uint32_t kept = 0;
+			for (const uint32_t literal : clause)
+			{
+				if (isTrue(literal))
+				{
+					satisfied = true;
+					break;
+				}
+				if (!isFalse(literal))
+					clause[kept++] = literal;
+			}
+			if (satisfied)
+			{
+				deleted[ci] = true;
+				continue;
+			}
+			clause.resize(kept);
+			if (kept == 0)
+			{
+				unsatisfiable = true;
+				return false;
+			}
+			if (kept == 1)
+			{
+				assign(clause.front());
+				deleted[ci] = true;
+				assigned = true;
+			}
+		}
+	}
+	return true;
+}
+
+bool ClauseSimplifier::substituteEquivalences()
+{
+	// the strongly connected components of the binary implication graph are sets of equivalent literals,
+	// every literal is replaced by the literal of the lowest variable of its component
+	const uint32_t literalCount = variableCount * 2;
+	vec<uint32_t> edgeStarts(literalCount + 1, 0);
+	for (uint32_t ci = 0; ci < clauses.size(); ci++)
+	{
+		if (!deleted[ci] && clauses[ci].size() == 2)
+		{
+			edgeStarts[clauses[ci][0] ^ 1]++;
+			edgeStarts[clauses[ci][1] ^ 1]++;
+		}
+	}
+	for (uint32_t literal = 0; literal < literalCount; literal++)
+		edgeStarts[literal + 1] += edgeStarts[literal];
+	vec<uint32_t> edges(edgeStarts[literalCount]);
+	for (uint32_t ci = 0; ci < clauses.size(); ci++)
+	{
+		if (!deleted[ci] && clauses[ci].size() == 2)
+		{
+			edges[--edgeStarts[clauses[ci][0] ^ 1]] = clauses[ci][1];
+			edges[--edgeStarts[clauses[ci][1] ^ 1]] = clauses[ci][0];
+		}
+	}
+	if (edges.empty())
+		return false;
+
+	// iterative Tarjan
+	vec<uint32_t> indices(literalCount, NoLiteral);
+	vec<uint32_t> lowLinks(literalCount, 0);
+	vec<uint32_t> representatives(literalCount, NoLiteral);
+	vec<bool> onStack(literalCount, false);
+	vec<uint32_t> stack;
+	vec<pair<uint32_t, uint32_t>> calls;
+	uint32_t nextIndex = 0;
+	for (uint32_t start = 0; start < literalCount; start++)
+	{
+		if (indices[start] != NoLiteral)
+			continue;
+		calls.push_back({ start, edgeStarts[start] });
+		indices[start] = lowLinks[start] = nextIndex++;
+		stack.push_back(start);
+		onStack[start] = true;
+		while (!calls.empty())
+		{
+			const uint32_t literal = calls.back().first;
+			uint32_t& edge = calls.back().second;
+			if (edge < edgeStarts[literal + 1])
+			{
+				const uint32_t next = edges[edge++];
+				if (indices[next] == NoLiteral)
+				{
+					indices[next] = lowLinks[next] = nextIndex++;
+					stack.push_back(next);
+					onStack[next] = true;
+					calls.push_back({ next, edgeStarts[next] });
+				}
+				else if (onStack[next])
+					lowLinks[literal] = std::min(lowLinks[literal], indices[next]);
+				continue;
+			}
+			calls.pop_back();
+			if (!calls.empty())
+				lowLinks[calls.back().first] = std::min(lowLinks[calls.back().first], lowLinks[literal]);
+			if (lowLinks[literal] != indices[literal])
+				continue;
+			const size_t componentStart = std::find(stack.begin(), stack.end(), literal) - stack.begin();
+			const uint32_t representative = *std::min_element(stack.begin() + componentStart, stack.end());
+			for (size_t si = componentStart; si < stack.size(); si++)
+			{
+				representatives[stack[si]] = representative;
+				onStack[stack[si]] = false;
+			}
+			stack.resize(componentStart);
+		}
+	}
+
+	uint32_t substituted = 0;
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		const uint32_t representative = representatives[variable << 1];
+		if (representatives[variable << 1 | 1] == representative)
+		{
+			unsatisfiable = true;
+			return true;
+		}
+		if (representative >> 1 != variable)
+		{
+			substitutes[variable] = representative;
+			substituted++;
+		}
+	}
+	if (!substituted)
+		return false;
+	stats.substitutedVariables += substituted;
+	for (uint32_t ci = 0; ci < clauses.size(); ci++)
+	{
+		if (deleted[ci])
+			continue;
+		vec<uint32_t>& clause = clauses[ci];
+		for (uint32_t& literal : clause)
+			literal = substitutes[literal >> 1] ^ (literal & 1);
+		if (!normalizeClause(clause))
+			deleted[ci] = true;
+	}
+	return true;
+}
+
+bool ClauseSimplifier::subsume()
+{
+	// every clause C removes the clauses it is a subset of, and removes the literal ~l from the clauses
+	// that contain C with l replaced by ~l (self-subsuming resolution)
+	buildOccurrences();
+	vec<uint32_t> order;
+	for (uint32_t ci = 0; ci < clauses.size(); ci++)
+	{
+		if (!deleted[ci])
+			order.push_back(ci);
+	}
+	std::stable_sort(order.begin(), order.end(), [this](const uint32_t lhs, const uint32_t rhs) { return clauses[lhs].size() < clauses[rhs].size(); });
+	bool changed = false;
+	for (const uint32_t ci : order)
+	{
+		if (deleted[ci])
+			continue;
+		const vec<uint32_t>& clause = clauses[ci];
+		uint32_t best = clause.front();
+		for (const uint32_t literal : clause)
+		{
+			marks[literal] = 1;
+			if (occurrences[literal].size() + occurrences[literal ^ 1].size() < occurrences[best].size() + occurrences[best ^ 1].size())
+				best = literal;
+		}
+		// every clause that contains the clause (up to one flipped literal) contains best or ~best
+		for (const uint32_t side : { best, best ^ 1 })
+		{
+			for (const uint32_t di : occurrences[side])
+			{
+				if (di == ci || deleted[di] || clauses[di].size() < clause.size())
+					continue;
+				uint32_t matched = 0;
+				uint32_t flipped = NoLiteral;
+				bool twice = false;
+				for (const uint32_t literal : clauses[di])
+				{
+					if (marks[literal])
+						matched++;
+					else if (marks[literal ^ 1])
+					{
+						twice = flipped != NoLiteral;
+						flipped = literal;
+					}
+				}
+				if (twice || matched + (flipped != NoLiteral) < clause.size())
+					continue;
+				changed = true;
+				if (flipped == NoLiteral)
+				{
+					deleted[di] = true;
+					stats.subsumedClauses++;
+					continue;
+				}
+				vec<uint32_t>& strengthened = clauses[di];
+				strengthened.erase(std::find(strengthened.begin(), strengthened.end(), flipped));
+				stats.strengthenedClauses++;
+				if (strengthened.empty())
+				{
+					unsatisfiable = true;
+					for (const uint32_t literal : clause)
+						marks[literal] = 0;
+					return true;
+				}
+			}
+		}
+		for (const uint32_t literal : clause)
+			marks[literal] = 0;
+	}
+	return changed;
+}
+
+bool ClauseSimplifier::probe()
+{
+	// a literal whose propagation ends in a conflict is false in every model
+	buildOccurrences();
+	bool changed = false;
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		if (values[variable] != Unset || (occurrences[variable << 1].empty() && occurrences[variable << 1 | 1].empty()))
+			continue;
+		for (const uint32_t literal : { variable << 1, variable << 1 | 1 })
+		{
+			if (probeLiteral(literal))
+				continue;
+			stats.failedLiterals++;
+			changed = true;
+			if (!probeLiteral(literal ^ 1))
+			{
+				unsatisfiable = true;
+				return true;
+			}
+			assign(literal ^ 1);
+			break;
+		}
+	}
+	return changed;
+}
+
+bool ClauseSimplifier::probeLiteral(const uint32_t literal)
+{
+	trail.clear();
+	assign(literal);
+	trail.push_back(literal);
+	bool conflict = false;
+	for (uint32_t ti = 0; ti < trail.size() && !conflict; ti++)
+	{
+		for (const uint32_t ci : occurrences[trail[ti] ^ 1])
+		{
+			if (deleted[ci])
+				continue;
+			uint32_t unassigned = NoLiteral;
+			uint32_t unassignedCount = 0;
+			bool satisfied = false;
+			for (const uint32_t other : clauses[ci])
+			{
+				if (isTrue(other))
+				{
+					satisfied = true;
+					break;
+				}
+				if (!isFalse(other))
+				{
+					unassigned = other;
+					unassignedCount++;
+				}
+			}
+			if (satisfied || unassignedCount > 1)
+				continue;
+			if (unassignedCount == 0)
+			{
+				conflict = true;
+				break;
+			}
+			assign(unassigned);
+			trail.push_back(unassigned);
+		}
+	}
+	for (const uint32_t assigned : trail)
+		values[assigned >> 1] = Unset;
+	return !conflict;
+}
+
+bool ClauseSimplifier::eliminateDefined()
+{
+	buildOccurrences();
+	bool changed = false;
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		if (values[variable] != Unset || substitutes[variable] != variable << 1 || eliminated[variable])
+			continue;
+		if (eliminateDefined(variable << 1) || eliminateDefined(variable << 1 | 1))
+		{
+			eliminated[variable] = true;
+			stats.eliminatedVariables++;
+			changed = true;
+			buildOccurrences();
+		}
+	}
+	return changed;
+}
+
+bool ClauseSimplifier::eliminateDefined(const uint32_t literal)
+{
+	// looks for the gate literal <=> (l_1 & ... & l_k), given by the clauses (~literal | l_i) and (literal | ~l_1 | ... | ~l_k);
+	// the formula is equivalent to the gate together with the resolvents of the other clauses of the variable with the gate,
+	// so the variable stays determined by the gate and the count does not change
+	const uint32_t negation = literal ^ 1;
+	for (const uint32_t ci : occurrences[negation])
+	{
+		if (!deleted[ci] && clauses[ci].size() == 2)
+			marks[clauses[ci][clauses[ci][0] == negation]] = 1;
+	}
+	uint32_t gate = NoLiteral;
+	for (const uint32_t ci : occurrences[literal])
+	{
+		if (deleted[ci] || clauses[ci].size() < 2)
+			continue;
+		bool defines = true;
+		for (const uint32_t other : clauses[ci])
+			defines = defines && (other == literal || marks[other ^ 1]);
+		if (defines)
+		{
+			gate = ci;
+			break;
+		}
+	}
+	for (const uint32_t ci : occurrences[negation])
+	{
+		if (!deleted[ci] && clauses[ci].size() == 2)
+			marks[clauses[ci][clauses[ci][0] == negation]] = 0;
+	}
+	if (gate == NoLiteral)
+		return false;
+
+	vec<uint32_t> gateBinaries;
+	for (const uint32_t other : clauses[gate])
+	{
+		if (other == literal)
+			continue;
+		for (const uint32_t ci : occurrences[negation])
+		{
+			if (!deleted[ci] && clauses[ci].size() == 2 && clauses[ci][clauses[ci][0] == negation] == (other ^ 1))
+			{
+				gateBinaries.push_back(ci);
+				break;
+			}
+		}
+	}
+	vec<uint32_t> positive;
+	vec<uint32_t> negative;
+	for (const uint32_t ci : occurrences[literal])
+	{
+		if (!deleted[ci] && ci != gate)
+			positive.push_back(ci);
+	}
+	for (const uint32_t ci : occurrences[negation])
+	{
+		if (!deleted[ci] && std::find(gateBinaries.begin(), gateBinaries.end(), ci) == gateBinaries.end())
+			negative.push_back(ci);
+	}
+	if (positive.empty() && negative.empty())
+		return false;
+
+	vec<vec<uint32_t>> resolvents;
+	const auto& resolve = [&](const uint32_t lhs, const uint32_t rhs, const uint32_t pivot)
+	{
+		vec<uint32_t> resolvent;
+		for (const uint32_t other : clauses[lhs])
+		{
+			if (other >> 1 != pivot >> 1)
+				resolvent.push_back(other);
+		}
+		for (const uint32_t other : clauses[rhs])
+		{
+			if (other >> 1 != pivot >> 1)
+				resolvent.push_back(other);
+		}
+		if (normalizeClause(resolvent))
+			resolvents.push_back(std::move(resolvent));
+	};
+	for (const uint32_t ci : positive)
+	{
+		for (const uint32_t bi : gateBinaries)
+			resolve(ci, bi, literal);
+	}
+	for (const uint32_t ci : negative)
+		resolve(gate, ci, literal);
+	// bounded: the resolvents may not outnumber the clauses they replace
+	if (resolvents.size() > positive.size() + negative.size())
+		return false;
+	for (const uint32_t ci : positive)
+		deleted[ci] = true;
+	for (const uint32_t ci : negative)
+		deleted[ci] = true;
+	for (vec<uint32_t>& resolvent : resolvents)
+		addClause(std::move(resolvent));
+	return true;
+}
+
+vec<vec<FlatProperty>> ClauseSimplifier::buildResult()
+{
+	vec<vec<uint32_t>> result;
+	if (unsatisfiable)
+		result.push_back({});
+	else
+	{
+		for (uint32_t ci = 0; ci < clauses.size(); ci++)
+		{
+			if (!deleted[ci])
+				result.push_back(clauses[ci]);
+		}
+		for (uint32_t variable = 0; variable < variableCount; variable++)
+		{
+			if (values[variable] != Unset)
+				result.push_back({ variable << 1 | !values[variable] });
+			// the substituted variables keep their equivalences, so they stay determined
+			const uint32_t substitute = substitutes[variable];
+			if (substitute != variable << 1)
+			{
+				result.push_back({ variable << 1 | 1, substitute });
+				result.push_back({ variable << 1, substitute ^ 1 });
+			}
+		}
+	}
+	for (vec<uint32_t>& clause : result)
+		std::sort(clause.begin(), clause.end());
+	std::sort(result.begin(), result.end(), [](const vec<uint32_t>& lhs, const vec<uint32_t>& rhs)
+	{
+		return lhs.size() < rhs.size() || (lhs.size() == rhs.size() && lhs < rhs);
+	});
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+
+	vec<vec<FlatProperty>> relations(result.size());
+	for (uint32_t ri = 0; ri < result.size(); ri++)
+	{
+		relations[ri].reserve(result[ri].size());
+		for (const uint32_t literal : result[ri])
+			relations[ri].push_back(FlatProperty(literal >> 1, literal & 1));
+		stats.literalsAfter += result[ri].size();
+	}
+	stats.clausesAfter = relations.size();
+	return relations;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vec.hpp"
+
+struct FlatProperty;
+
+struct SimplificationOptions
+{
+	bool subsumption = true;
+	bool probing = true;
+	bool equivalences = true;
+	// replaces the clauses of the variables defined by AND gates with their resolvents against the gates,
+	// the gates themselves are kept so that the variables stay determined and the count does not change
+	bool eliminateDefined = false;
+};
+
+struct SimplificationStats
+{
+	size_t clausesBefore = 0;
+	size_t literalsBefore = 0;
+	size_t clausesAfter = 0;
+	size_t literalsAfter = 0;
+	size_t subsumedClauses = 0;
+	size_t strengthenedClauses = 0;
+	size_t failedLiterals = 0;
+	size_t substitutedVariables = 0;
+	size_t eliminatedVariables = 0;
+
+	SimplificationStats& operator+=(const SimplificationStats& other);
+};
+
+// Simplifies a set of flat relations (clauses) into a set with exactly the same models over all the variables,
+// so that the counts, the conditioned counts and the marginals of a type do not change.
+// Fixed variables are kept as unit clauses and substituted variables as the equivalences with their representatives,
+// so no variable becomes free.
+class ClauseSimplifier
+{
+public:
+	ClauseSimplifier(uint32_t variableCount, const SimplificationOptions& options = SimplificationOptions());
+
+	// returns the simplified clauses sorted by size and then lexicographically, with sorted literals
+	vec<vec<FlatProperty>> simplify(const vec<vec<FlatProperty>>& relations);
+
+	const SimplificationStats& getStats() const;
+
+private:
+	static constexpr uint8_t Unset = 2;
+
+	// literals are encoded as (variable << 1 | negated)
+	uint32_t variableCount;
+	SimplificationOptions options;
+	SimplificationStats stats;
+
+	vec<vec<uint32_t>> clauses;
+	vec<bool> deleted;
+	vec<uint8_t> values;
+	// the literal every variable was substituted by, or the positive literal of the variable
+	vec<uint32_t> substitutes;
+	vec<bool> eliminated;
+	bool unsatisfiable = false;
+
+	vec<vec<uint32_t>> occurrences;
+	vec<uint8_t> marks;
+	vec<uint32_t> trail;
+
+	bool isTrue(uint32_t literal) const;
+	bool isFalse(uint32_t literal) const;
+	void assign(uint32_t literal);
+
+	void addClause(vec<uint32_t> literals);
+	void buildOccurrences();
+
+	bool propagateUnits();
+	bool substituteEquivalences();
+	bool subsume();
+	bool probe();
+	bool probeLiteral(uint32_t literal);
+	bool eliminateDefined();
+	bool eliminateDefined(uint32_t literal);
+
+	vec<vec<FlatProperty>> buildResult();
+};
\ No newline at end of file
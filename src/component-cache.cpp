@@ -0,0 +1,96 @@
+#include "component-cache.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+ComponentCache::ComponentCache(const size_t memoryLimit) : memoryLimit(memoryLimit)
+{
+}
+
+bool ComponentCache::find(const ComponentKey& key, size_t& count)
+{
+	const auto found = entries.find(key);
+	if (found == entries.end())
+	{
+		misses++;
+		return false;
+	}
+	hits++;
+	found->second.lastUse = ++clock;
+	count = found->second.count;
+	return true;
+}
+
+void ComponentCache::insert(const ComponentKey& key, const size_t count)
+{
+	const auto inserted = entries.insert({ key, { count, ++clock } });
+	if (!inserted.second)
+		return;
+	// the stored copy is measured, the caller's key may have a larger capacity
+	memoryUsage += getEntrySize(inserted.first->first);
+	if (memoryUsage > memoryLimit)
+		evict();
+}
+
+void ComponentCache::clear()
+{
+	entries.clear();
+	memoryUsage = 0;
+}
+
+size_t ComponentCache::getEntryCount() const
+{
+	return entries.size();
+}
+
+size_t ComponentCache::getMemoryUsage() const
+{
+	return memoryUsage;
+}
+
+size_t ComponentCache::getHitCount() const
+{
+	return hits;
+}
+
+size_t ComponentCache::getMissCount() const
+{
+	return misses;
+}
+
+size_t ComponentCache::getEvictionCount() const
+{
+	return evictions;
+}
+
+size_t ComponentCache::getEntrySize(const ComponentKey& key)
+{
+	// the hash node with its key, value and bucket pointer, plus the heap block of the key
+	return sizeof(ComponentKey) + sizeof(Entry) + 3 * sizeof(void*) + key.words.size() * sizeof(uint32_t);
+}
+
+void ComponentCache::evict()
+{
+	vec<uint64_t> uses;
+	uses.reserve(entries.size());
+	for (const auto& entry : entries)
+		uses.push_back(entry.second.lastUse);
+	// entries are removed from the oldest, so the threshold is the use time below which a quarter of the memory is kept free
+	std::sort(uses.begin(), uses.end());
+	const size_t target = memoryLimit / 4 * 3;
+	const size_t averageSize = memoryUsage / entries.size();
+	const size_t keep = std::min(entries.size(), target / std::max<size_t>(averageSize, 1));
+	const uint64_t threshold = keep == 0 ? clock + 1 : uses[uses.size() - keep];
+	for (auto it = entries.begin(); it != entries.end();)
+	{
+		if (it->second.lastUse < threshold)
+		{
+			memoryUsage -= getEntrySize(it->first);
+			evictions++;
+			it = entries.erase(it);
+		}
+		else
+			it++;
+	}
+	assert(!entries.empty() || memoryUsage == 0);
+}
\ No newline at end of file
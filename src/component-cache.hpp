@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "umap.hpp"
+#include "vec.hpp"
+
+// canonical encoding of a residual component: the owning workspace, the sorted variables and the sorted unsatisfied clauses,
+// or of the assumptions a promotion target is counted under: the tagged workspace and the packed assignment
+struct ComponentKey
+{
+	vec<uint32_t> words;
+
+	bool operator==(const ComponentKey& other) const
+	{
+		return words == other.words;
+	}
+};
+
+namespace std
+{
+
+template<>
+struct hash<ComponentKey>
+{
+	size_t operator()(const ComponentKey& key) const
+	{
+		uint64_t hsh = 0x9e3779b97f4a7c15ull ^ key.words.size();
+		for (const uint32_t word : key.words)
+		{
+			hsh ^= word + 0x9e3779b97f4a7c15ull + (hsh << 6) + (hsh >> 2);
+			hsh *= 0xff51afd7ed558ccdull;
+		}
+		return hsh ^ (hsh >> 33);
+	}
+};
+
+}
+
+// Memoizes the counts of residual components in the style of sharpSAT.
+// When the estimated memory use exceeds the limit, the least recently used entries are evicted until it drops to three quarters of the limit.
+class ComponentCache
+{
+public:
+	ComponentCache(size_t memoryLimit);
+
+	// returns true and sets the count if the component is cached
+	bool find(const ComponentKey& key, size_t& count);
+	void insert(const ComponentKey& key, size_t count);
+	void clear();
+
+	size_t getEntryCount() const;
+	size_t getMemoryUsage() const;
+	size_t getHitCount() const;
+	size_t getMissCount() const;
+	size_t getEvictionCount() const;
+
+private:
+	struct Entry
+	{
+		size_t count;
+		uint64_t lastUse;
+	};
+
+	umap<ComponentKey, Entry> entries;
+	size_t memoryLimit;
+	size_t memoryUsage = 0;
+	uint64_t clock = 0;
+
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+
+	static size_t getEntrySize(const ComponentKey& key);
+	void evict();
+};
\ No newline at end of file
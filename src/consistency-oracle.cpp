@@ -0,0 +1,87 @@
+#include "consistency-oracle.hpp"
+
+#include <cassert>
+
+ConsistencyOracle::ConsistencyOracle(const StructType& type) : type(&type)
+{
+	assert(type.isPreprocessed());
+}
+
+bool ConsistencyOracle::isConsistent(const PartialAssignment& assumptions)
+{
+	assert(assumptions.getVariableCount() == type->getDeepPropertyDistinctCount());
+	queryCount++;
+	return isConsistent(*type, assumptions);
+}
+
+bool ConsistencyOracle::implies(const PartialAssignment& premises, const uint32_t variable, const bool value)
+{
+	if (!premises.allows(variable, !value))
+		return true;
+	PartialAssignment assumptions = premises;
+	assumptions.set(variable, !value);
+	return !isConsistent(assumptions);
+}
+
+size_t ConsistencyOracle::getQueryCount() const
+{
+	return queryCount;
+}
+
+size_t ConsistencyOracle::getConflictCount() const
+{
+	size_t total = 0;
+	for (const auto& solver : solvers)
+		total += solver.second->getConflictCount();
+	return total;
+}
+
+size_t ConsistencyOracle::getLearnedCount() const
+{
+	size_t total = 0;
+	for (const auto& solver : solvers)
+		total += solver.second->getLearnedCount();
+	return total;
+}
+
+SatSolver& ConsistencyOracle::getSolver(const StructType& solvedType)
+{
+	uptr<SatSolver>& solver = solvers[&solvedType];
+	if (solver)
+		return *solver;
+	solver = make_unique<SatSolver>(solvedType.getDeepPropertyDistinctCount());
+	const ClauseArena& relations = solvedType.flatRelations;
+	for (uint32_t clause = 0; clause < relations.getClauseCount(); clause++)
+	{
+		if (!solver->addClause(vec<uint32_t>(relations[clause].begin(), relations[clause].end())))
+			break;
+	}
+	return *solver;
+}
+
+bool ConsistencyOracle::isConsistent(const StructType& solvedType, const PartialAssignment& assumptions)
+{
+	// an instance with a promoted property is an instance of the type it promotes to, so the promotions are tried first
+	// (as in the conditioned count) and the type itself is solved with all its promoted properties false
+	PartialAssignment current = assumptions;
+	for (const Promotion& promotion : solvedType.getPromotions())
+	{
+		const bool assumedTrue = current.isSpecified(promotion.property) && current.getValue(promotion.property);
+		if (current.isSpecified(promotion.property) && !assumedTrue)
+			continue;
+		PartialAssignment projected;
+		const bool consistent = promotion.project(current, projected);
+		if (consistent && isConsistent(*promotion.target, projected))
+			return true;
+		if (assumedTrue)
+			return false;
+		current.set(promotion.property, false);
+	}
+	vec<uint32_t> literals;
+	for (uint32_t variable = 0; variable < current.getVariableCount(); variable++)
+	{
+		if (current.isSpecified(variable))
+			literals.push_back(variable << 1 | !current.getValue(variable));
+	}
+	return getSolver(solvedType).solve(literals);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "partial-assignment.hpp"
+#include "ptr.hpp"
+#include "sat-solver.hpp"
+#include "umap.hpp"
+
+#include "struct-type.hpp"
+
+// Answers whether some instance of a preprocessed type agrees with a partial assignment of its deep properties,
+// and so whether a combination of properties implies another one, without counting.
+// Every type of the promotion chain gets its own solver over its flatRelations, built on the first query that reaches it;
+// the solvers keep their learned clauses, so the cost of a query falls as more queries are asked.
+class ConsistencyOracle
+{
+public:
+	ConsistencyOracle(const StructType& type);
+
+	bool isConsistent(const PartialAssignment& assumptions);
+	// whether every instance that agrees with the premises has the property with the value
+	bool implies(const PartialAssignment& premises, uint32_t variable, bool value);
+
+	size_t getQueryCount() const;
+	// the conflicts and the learned clauses of all the solvers
+	size_t getConflictCount() const;
+	size_t getLearnedCount() const;
+
+private:
+	const StructType* type;
+	umap<const StructType*, uptr<SatSolver>> solvers;
+	size_t queryCount = 0;
+
+	SatSolver& getSolver(const StructType& type);
+	bool isConsistent(const StructType& type, const PartialAssignment& assumptions);
+};
\ No newline at end of file
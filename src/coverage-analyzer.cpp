@@ -0,0 +1,121 @@
+#include "coverage-analyzer.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+CoverageAnalyzer::CoverageAnalyzer(const StructType& type) : type(&type), oracle(type)
+{
+	for (PropertyHandle handle = 1; handle <= type.getPropertyCount(); handle++)
+	{
+		// equal top-level properties share a flat property
+		const uint32_t index = type.getDeepPropertyIndex(DeepPropertyHandle(handle));
+		if (std::find(topLevelProperties.begin(), topLevelProperties.end(), index) == topLevelProperties.end())
+			topLevelProperties.push_back(index);
+	}
+	collectExampleCubes(type, exampleCubes);
+	for (PartialAssignment& cube : exampleCubes)
+	{
+		// only the top-level properties of the examples decide what they cover
+		for (uint32_t variable = 0; variable < cube.getVariableCount(); variable++)
+		{
+			if (std::find(topLevelProperties.begin(), topLevelProperties.end(), variable) == topLevelProperties.end())
+				cube.unset(variable);
+		}
+	}
+}
+
+const vec<uint32_t>& CoverageAnalyzer::getTopLevelProperties() const
+{
+	return topLevelProperties;
+}
+
+const vec<PartialAssignment>& CoverageAnalyzer::getExampleCubes() const
+{
+	return exampleCubes;
+}
+
+void CoverageAnalyzer::collectExampleCubes(const StructType& collectedType, vec<PartialAssignment>& cubes)
+{
+	for (const Example& example : collectedType.getExamples())
+	{
+		if (example.contradiction == example.properties.size())
+			cubes.push_back(example.assignment);
+	}
+	// an example of a promotion target is an example of the type with the promoted property
+	for (const Promotion& promotion : collectedType.getPromotions())
+	{
+		vec<PartialAssignment> targetCubes;
+		collectExampleCubes(*promotion.target, targetCubes);
+		for (const PartialAssignment& targetCube : targetCubes)
+		{
+			PartialAssignment cube(collectedType.getDeepPropertyDistinctCount());
+			for (uint32_t variable = 0; variable < cube.getVariableCount(); variable++)
+			{
+				if (targetCube.isSpecified(promotion.propertyMap[variable]))
+					cube.set(variable, targetCube.getValue(promotion.propertyMap[variable]));
+			}
+			cube.set(promotion.property, true);
+			cubes.push_back(cube);
+		}
+	}
+}
+
+bool CoverageAnalyzer::isCovered(const PartialAssignment& cube) const
+{
+	// the cube is covered if an example states a subset of its values
+	for (const PartialAssignment& example : exampleCubes)
+	{
+		bool contains = true;
+		for (uint32_t wi = 0; wi < example.getSpecifiedWords().size() && contains; wi++)
+		{
+			const uint64_t specified = example.getSpecifiedWords()[wi];
+			contains = (specified & ~cube.getSpecifiedWords()[wi]) == 0 && ((example.getValueWords()[wi] ^ cube.getValueWords()[wi]) & specified) == 0;
+		}
+		if (contains)
+			return true;
+	}
+	return false;
+}
+
+vec<CoverageCube> CoverageAnalyzer::findUncovered()
+{
+	vec<CoverageCube> uncovered;
+	PartialAssignment cube(type->getDeepPropertyDistinctCount());
+	explore(cube, 0, uncovered);
+	for (CoverageCube& coverageCube : uncovered)
+	{
+		PropertyRelations assumptions;
+		for (PropertyHandle handle = 1; handle <= type->getPropertyCount(); handle++)
+		{
+			const uint32_t index = type->getDeepPropertyIndex(DeepPropertyHandle(handle));
+			if (coverageCube.cube.isSpecified(index))
+				assumptions.push_back({ DeepProperty(DeepPropertyHandle(handle), !coverageCube.cube.getValue(index)) });
+		}
+		coverageCube.instanceCount = type->getPossibleInstancesCount(assumptions);
+	}
+	return uncovered;
+}
+
+bool CoverageAnalyzer::explore(PartialAssignment& cube, const uint32_t depth, vec<CoverageCube>& uncovered)
+{
+	// returns whether all the combinations in the cube are consistent and uncovered, in which case the cube is the last one added
+	if (!oracle.isConsistent(cube) || isCovered(cube))
+		return false;
+	if (depth == topLevelProperties.size())
+	{
+		uncovered.push_back({ cube, 1, 0 });
+		return true;
+	}
+	const uint32_t variable = topLevelProperties[depth];
+	cube.set(variable, false);
+	const bool falseFull = explore(cube, depth + 1, uncovered);
+	cube.set(variable, true);
+	const bool trueFull = explore(cube, depth + 1, uncovered);
+	cube.unset(variable);
+	if (!falseFull || !trueFull)
+		return false;
+	const size_t combinationCount = uncovered[uncovered.size() - 2].combinationCount * 2;
+	uncovered.resize(uncovered.size() - 2);
+	uncovered.push_back({ cube, combinationCount, 0 });
+	return true;
+}
\ No newline at end of file
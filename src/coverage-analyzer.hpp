@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "consistency-oracle.hpp"
+#include "partial-assignment.hpp"
+#include "struct-type.hpp"
+#include "vec.hpp"
+
+// A set of combinations of the top-level properties of a type, the ones specified in the cube with any values of the others.
+struct CoverageCube
+{
+	// over the flat properties of the type, only the top-level properties are specified
+	PartialAssignment cube;
+	// the number of the combinations of the top-level properties in the cube, all of them consistent
+	size_t combinationCount;
+	// the number of the instances of the type in the cube
+	size_t instanceCount;
+};
+
+// Finds the consistent combinations of the top-level properties of a preprocessed type that no example covers.
+// An example covers the combinations that agree with the values it states, its promotion targets' examples included.
+// The combinations are searched property by property with the consistency oracle pruning the inconsistent
+// and the covered branches, and the branches whose both halves are entirely uncovered are merged into a single cube,
+// so the work depends on the number of the consistent combinations rather than on the number of the instances.
+class CoverageAnalyzer
+{
+public:
+	CoverageAnalyzer(const StructType& type);
+
+	vec<CoverageCube> findUncovered();
+
+	// the flat indices of the top-level properties, in the order they are branched on
+	const vec<uint32_t>& getTopLevelProperties() const;
+	// the examples as cubes over the flat properties of the type
+	const vec<PartialAssignment>& getExampleCubes() const;
+
+private:
+	const StructType* type;
+	ConsistencyOracle oracle;
+	vec<uint32_t> topLevelProperties;
+	vec<PartialAssignment> exampleCubes;
+
+	static void collectExampleCubes(const StructType& type, vec<PartialAssignment>& cubes);
+	bool isCovered(const PartialAssignment& cube) const;
+	bool explore(PartialAssignment& cube, uint32_t depth, vec<CoverageCube>& uncovered);
+};
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "example-validator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+ExampleValidator::ExampleValidator(const StructType& type) : type(&type)
+{
+	assert(type.isPreprocessed());
+}
+
+size_t ExampleValidator::validate(ErrorReporter& er)
+{
+	const vec<Example>& examples = type->getExamples();
+	vec<PartialAssignment> assignments;
+	vec<uint32_t> exampleIndices;
+	size_t inconsistent = 0;
+	for (uint32_t ei = 0; ei < examples.size(); ei++)
+	{
+		const Example& example = examples[ei];
+		if (example.contradiction != example.properties.size())
+		{
+			er.reportSem(example.lineNumber, "The example \"" + example.name + "\" of " + type->getName() + " states both values of "
+				+ type->getDeepPropertyName(type->getDeepPropertyIndex(example.properties[example.contradiction].handle)) + ".");
+			inconsistent++;
+			continue;
+		}
+		assignments.push_back(example.assignment);
+		exampleIndices.push_back(ei);
+	}
+	const vec<Violation> violations = check(assignments);
+	for (uint32_t ai = 0; ai < assignments.size(); ai++)
+	{
+		const Violation& violation = violations[ai];
+		if (!violation.type)
+			continue;
+		const Example& example = examples[exampleIndices[ai]];
+		const str where = violation.type == type ? "" : " when promoted to " + violation.type->getName();
+		if (violation.relation == NoRelation)
+			er.reportSem(example.lineNumber, "The example \"" + example.name + "\" of " + type->getName() + where + " states both values of a property.");
+		else
+			er.reportSem(example.lineNumber, "The example \"" + example.name + "\" of " + type->getName() + where + " violates the relation "
+				+ ExampleValidator(*violation.type).getRelationText(violation.relation) + ".");
+		inconsistent++;
+	}
+	return inconsistent;
+}
+
+vec<ExampleValidator::Violation> ExampleValidator::check(const vec<PartialAssignment>& assignments) const
+{
+	vec<Violation> violations(assignments.size());
+	for (uint32_t begin = 0; begin < assignments.size(); begin += 64)
+		checkBlock(assignments, begin, std::min<uint32_t>(begin + 64, assignments.size()), violations);
+
+	// the assignments with a promoted property true are instances of the target as well
+	for (const Promotion& promotion : type->getPromotions())
+	{
+		vec<PartialAssignment> projected;
+		vec<uint32_t> indices;
+		for (uint32_t ai = 0; ai < assignments.size(); ai++)
+		{
+			const PartialAssignment& assignment = assignments[ai];
+			if (violations[ai].type || !assignment.isSpecified(promotion.property) || !assignment.getValue(promotion.property))
+				continue;
+			PartialAssignment projection;
+			if (!promotion.project(assignment, projection))
+			{
+				violations[ai].type = promotion.target;
+				continue;
+			}
+			projected.push_back(std::move(projection));
+			indices.push_back(ai);
+		}
+		if (projected.empty())
+			continue;
+		const vec<Violation> targetViolations = ExampleValidator(*promotion.target).check(projected);
+		for (uint32_t pi = 0; pi < projected.size(); pi++)
+		{
+			if (targetViolations[pi].type)
+				violations[indices[pi]] = targetViolations[pi];
+		}
+	}
+	return violations;
+}
+
+void ExampleValidator::checkBlock(const vec<PartialAssignment>& assignments, const uint32_t begin, const uint32_t end, vec<Violation>& violations) const
+{
+	const uint32_t variableCount = type->getDeepPropertyDistinctCount();
+	vec<uint64_t> specified(variableCount, 0);
+	vec<uint64_t> values(variableCount, 0);
+	for (uint32_t ai = begin; ai < end; ai++)
+	{
+		const uint64_t bit = uint64_t(1) << (ai - begin);
+		const PartialAssignment& assignment = assignments[ai];
+		for (uint32_t variable = 0; variable < variableCount; variable++)
+		{
+			if (!assignment.isSpecified(variable))
+				continue;
+			specified[variable] |= bit;
+			if (assignment.getValue(variable))
+				values[variable] |= bit;
+		}
+	}
+
+	// the examples that are not yet known to be inconsistent
+	uint64_t active = end - begin == 64 ? ~uint64_t(0) : (uint64_t(1) << (end - begin)) - 1;
+	const ClauseArena& relations = type->flatRelations;
+	bool changed = true;
+	while (changed && active)
+	{
+		changed = false;
+		for (uint32_t ri = 0; ri < relations.getClauseCount() && active; ri++)
+		{
+			// the examples in which all the literals so far are false, and in which exactly one of them is unspecified
+			uint64_t allFalse = active;
+			uint64_t oneUnspecified = 0;
+			for (const uint32_t literal : relations[ri])
+			{
+				const uint32_t variable = literal >> 1;
+				const uint64_t isFalse = specified[variable] & (literal & 1 ? values[variable] : ~values[variable]);
+				oneUnspecified = (oneUnspecified & isFalse) | (allFalse & ~specified[variable]);
+				allFalse &= isFalse;
+			}
+			for (uint64_t violated = allFalse; violated; violated &= violated - 1)
+				violations[begin + __builtin_ctzll(violated)] = { type, ri };
+			active &= ~allFalse;
+			if (!oneUnspecified)
+				continue;
+			changed = true;
+			for (const uint32_t literal : relations[ri])
+			{
+				const uint32_t variable = literal >> 1;
+				const uint64_t implied = oneUnspecified & ~specified[variable];
+				specified[variable] |= implied;
+				if (literal & 1)
+					values[variable] &= ~implied;
+				else
+					values[variable] |= implied;
+			}
+		}
+	}
+}
+
+str ExampleValidator::getRelationText(const uint32_t relation) const
+{
+	str text;
+	for (const uint32_t literal : type->flatRelations[relation])
+	{
+		if (!text.empty())
+			text += " | ";
+		text += (literal & 1 ? "~" : "") + type->getDeepPropertyName(literal >> 1);
+	}
+	return text.empty() ? "false" : text;
+}
\ No newline at end of file
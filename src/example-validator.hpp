@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "parse-utils.hpp"
+#include "partial-assignment.hpp"
+#include "vec.hpp"
+
+#include "struct-type.hpp"
+
+// Checks the examples of a preprocessed type against its flat relations, 64 examples at a time.
+// The assignments of a block are transposed into a word of specified bits and a word of values per property,
+// the relations with a single unspecified literal assign it for all the examples of the block at once,
+// and an example violates a relation if its bit survives the AND of the words of the false literals.
+// The examples with a promoted property are also checked, projected, against the type it promotes to.
+class ExampleValidator
+{
+public:
+	static constexpr uint32_t NoRelation = std::numeric_limits<uint32_t>::max();
+
+	struct Violation
+	{
+		// the type whose relation is violated, nullptr if the assignment is consistent
+		const StructType* type = nullptr;
+		// the index of the violated flat relation, or NoRelation if the projection into a promotion target states both values of a property
+		uint32_t relation = NoRelation;
+	};
+
+	ExampleValidator(const StructType& type);
+
+	// reports every inconsistent example of the type and returns their number
+	size_t validate(ErrorReporter& er);
+	// the first violation found for every assignment
+	vec<Violation> check(const vec<PartialAssignment>& assignments) const;
+
+private:
+	const StructType* type;
+
+	void checkBlock(const vec<PartialAssignment>& assignments, uint32_t begin, uint32_t end, vec<Violation>& violations) const;
+	str getRelationText(uint32_t relation) const;
+};
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "implication-index.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <ostream>
+
+#include "struct-type.hpp"
+
+ImplicationIndex::ImplicationIndex(const StructType& type)
+	: variableCount(type.getDeepPropertyDistinctCount()), wordCount((2 * variableCount + 63) / 64)
+{
+	assert(type.isPreprocessed());
+	umap<const StructType*, vec<uint64_t>> built;
+	closures = buildClosures(type, built, componentCount);
+}
+
+uint32_t ImplicationIndex::getVariableCount() const
+{
+	return variableCount;
+}
+
+uint32_t ImplicationIndex::getWordCount() const
+{
+	return wordCount;
+}
+
+uint32_t ImplicationIndex::getComponentCount() const
+{
+	return componentCount;
+}
+
+void ImplicationIndex::printMatrix(std::ostream& output) const
+{
+	for (uint32_t literal0 = 0; literal0 < 2 * variableCount; literal0++)
+	{
+		for (uint32_t literal1 = 0; literal1 < 2 * variableCount; literal1++)
+			output << (implies(literal0, literal1) ? '1' : '0');
+		output << '\n';
+	}
+}
+
+const vec<uint64_t>& ImplicationIndex::buildClosures(const StructType& type, umap<const StructType*, vec<uint64_t>>& built, uint32_t& componentCount)
+{
+	const auto found = built.find(&type);
+	if (found != built.end())
+		return found->second;
+	vec<uint64_t> closures = buildOwnClosures(type, componentCount);
+	const uint32_t literalCount = 2 * type.getDeepPropertyDistinctCount();
+	const uint32_t wordCount = (literalCount + 63) / 64;
+	for (const Promotion& promotion : type.getPromotions())
+	{
+		uint32_t targetComponentCount;
+		const vec<uint64_t>& targetClosures = buildClosures(*promotion.target, built, targetComponentCount);
+		const uint32_t targetWordCount = (2 * promotion.target->getDeepPropertyDistinctCount() + 63) / 64;
+		const auto& map = [&promotion](const uint32_t literal)
+		{
+			return promotion.propertyMap[literal >> 1] << 1 | (literal & 1);
+		};
+		for (uint32_t literal0 = 0; literal0 < literalCount; literal0++)
+		{
+			const uint64_t* targetClosure = &targetClosures[map(literal0) * targetWordCount];
+			for (uint32_t literal1 = 0; literal1 < literalCount; literal1++)
+			{
+				const uint32_t mapped = map(literal1);
+				if (!((targetClosure[mapped >> 6] >> (mapped & 63)) & 1))
+					closures[literal0 * wordCount + (literal1 >> 6)] &= ~(uint64_t(1) << (literal1 & 63));
+			}
+		}
+	}
+	return built[&type] = std::move(closures);
+}
+
+vec<uint64_t> ImplicationIndex::buildOwnClosures(const StructType& type, uint32_t& componentCount)
+{
+	static constexpr uint32_t NoIndex = std::numeric_limits<uint32_t>::max();
+	const uint32_t literalCount = 2 * type.getDeepPropertyDistinctCount();
+	const uint32_t wordCount = (literalCount + 63) / 64;
+
+	// a clause (a | b) gives the edges ~a -> b and ~b -> a, a unit clause (a) the edge ~a -> a;
+	// the instances of the type itself have all the promoted properties false
+	vec<vec<uint32_t>> edges(literalCount);
+	bool unsatisfiable = false;
+	const auto& addClause = [&edges](const uint32_t literal0, const uint32_t literal1)
+	{
+		edges[literal0 ^ 1].push_back(literal1);
+		if (literal1 != literal0)
+			edges[literal1 ^ 1].push_back(literal0);
+	};
+	for (uint32_t clause = 0; clause < type.flatRelations.getClauseCount(); clause++)
+	{
+		const ClauseArena::Clause relation = type.flatRelations[clause];
+		if (relation.empty())
+			unsatisfiable = true;
+		else if (relation.size() <= 2)
+			addClause(relation.front(), relation.back());
+	}
+	for (const Promotion& promotion : type.getPromotions())
+		addClause(promotion.property << 1 | 1, promotion.property << 1 | 1);
+
+	// Tarjan's algorithm with an explicit stack; a component is completed after all the components it reaches,
+	// so its closure is the union of its literals and the closures of its successors
+	vec<uint32_t> indices(literalCount, NoIndex);
+	vec<uint32_t> lowlinks(literalCount);
+	vec<uint32_t> components(literalCount, NoIndex);
+	vec<uint32_t> componentStack;
+	vec<pair<uint32_t, uint32_t>> callStack;
+	vec<uint64_t> componentClosures;
+	uint32_t nextIndex = 0;
+	componentCount = 0;
+	for (uint32_t start = 0; start < literalCount; start++)
+	{
+		if (indices[start] != NoIndex)
+			continue;
+		callStack.push_back({ start, 0 });
+		indices[start] = lowlinks[start] = nextIndex++;
+		componentStack.push_back(start);
+		while (!callStack.empty())
+		{
+			const uint32_t literal = callStack.back().first;
+			uint32_t& edge = callStack.back().second;
+			if (edge < edges[literal].size())
+			{
+				const uint32_t next = edges[literal][edge++];
+				if (indices[next] == NoIndex)
+				{
+					indices[next] = lowlinks[next] = nextIndex++;
+					componentStack.push_back(next);
+					callStack.push_back({ next, 0 });
+				}
+				else if (components[next] == NoIndex)
+					lowlinks[literal] = std::min(lowlinks[literal], indices[next]);
+				continue;
+			}
+			callStack.pop_back();
+			if (!callStack.empty())
+				lowlinks[callStack.back().first] = std::min(lowlinks[callStack.back().first], lowlinks[literal]);
+			if (lowlinks[literal] != indices[literal])
+				continue;
+			const uint32_t component = componentCount++;
+			componentClosures.resize(componentClosures.size() + wordCount, 0);
+			uint64_t* closure = &componentClosures[component * wordCount];
+			const uint32_t memberBegin = std::find(componentStack.begin(), componentStack.end(), literal) - componentStack.begin();
+			for (uint32_t mi = memberBegin; mi < componentStack.size(); mi++)
+			{
+				components[componentStack[mi]] = component;
+				closure[componentStack[mi] >> 6] |= uint64_t(1) << (componentStack[mi] & 63);
+			}
+			for (uint32_t mi = memberBegin; mi < componentStack.size(); mi++)
+			{
+				for (const uint32_t next : edges[componentStack[mi]])
+				{
+					if (components[next] == component)
+						continue;
+					const uint64_t* nextClosure = &componentClosures[components[next] * wordCount];
+					for (uint32_t wi = 0; wi < wordCount; wi++)
+						closure[wi] |= nextClosure[wi];
+				}
+			}
+			componentStack.resize(memberBegin);
+		}
+	}
+
+	vec<uint64_t> closures(literalCount * wordCount);
+	for (uint32_t literal = 0; literal < literalCount; literal++)
+		std::copy_n(&componentClosures[components[literal] * wordCount], wordCount, &closures[literal * wordCount]);
+
+	// a literal implying a complementary pair is impossible and implies everything, its complement holds in every instance
+	// and so does its closure; the literals forced that way are added to every closure until nothing new is impossible
+	const auto& has = [&](const uint32_t literal0, const uint32_t literal1)
+	{
+		return (closures[literal0 * wordCount + (literal1 >> 6)] >> (literal1 & 63)) & 1;
+	};
+	const auto& fill = [&](const uint32_t literal)
+	{
+		for (uint32_t bit = 0; bit < literalCount; bit++)
+			closures[literal * wordCount + (bit >> 6)] |= uint64_t(1) << (bit & 63);
+	};
+	vec<bool> impossible(literalCount, false);
+	vec<uint64_t> forced(wordCount, 0);
+	bool changed = true;
+	while (changed && !unsatisfiable)
+	{
+		changed = false;
+		for (uint32_t literal = 0; literal < literalCount; literal++)
+		{
+			if (impossible[literal])
+				continue;
+			for (uint32_t variable = 0; variable < literalCount / 2 && !impossible[literal]; variable++)
+				impossible[literal] = has(literal, variable << 1) && has(literal, variable << 1 | 1);
+			if (!impossible[literal])
+				continue;
+			changed = true;
+			fill(literal);
+			if (impossible[literal ^ 1])
+				unsatisfiable = true;
+			else
+			{
+				for (uint32_t wi = 0; wi < wordCount; wi++)
+					forced[wi] |= closures[(literal ^ 1) * wordCount + wi];
+			}
+		}
+		for (uint32_t literal = 0; literal < literalCount; literal++)
+		{
+			for (uint32_t wi = 0; wi < wordCount; wi++)
+				closures[literal * wordCount + wi] |= forced[wi];
+		}
+	}
+	if (unsatisfiable)
+	{
+		for (uint32_t literal = 0; literal < literalCount; literal++)
+			fill(literal);
+	}
+	return closures;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "umap.hpp"
+#include "vec.hpp"
+
+class StructType;
+
+// The implications between the literals of the deep properties of a preprocessed type, encoded as (property << 1 | negated),
+// that follow from its binary and unit relations. The implication graph of those relations is condensed into its strongly
+// connected components and the closure of every literal is stored as a bitset over all the literals.
+// The longer relations are not used, so the index may miss implications the consistency oracle finds, but all it has hold.
+// The instances with a promoted property are instances of the type it promotes to,
+// so the closures are intersected with the closures of the promotion targets.
+class ImplicationIndex
+{
+public:
+	ImplicationIndex(const StructType& type);
+
+	uint32_t getVariableCount() const;
+	uint32_t getWordCount() const;
+	// the number of the strongly connected components of the implication graph of the type itself
+	uint32_t getComponentCount() const;
+
+	// whether every instance with the first literal has the second one
+	bool implies(const uint32_t literal0, const uint32_t literal1) const
+	{
+		return (closures[literal0 * wordCount + (literal1 >> 6)] >> (literal1 & 63)) & 1;
+	}
+
+	// the getWordCount() words of the bitset of the literals implied by the literal
+	const uint64_t* getClosure(const uint32_t literal) const
+	{
+		return &closures[literal * wordCount];
+	}
+
+	// whether no instance has the literal (it implies every literal)
+	bool isImpossible(const uint32_t literal) const
+	{
+		return implies(literal, literal ^ 1);
+	}
+
+	// writes the whole matrix, a line of zeros and ones per literal
+	void printMatrix(std::ostream& output) const;
+
+private:
+	uint32_t variableCount;
+	uint32_t wordCount;
+	uint32_t componentCount = 0;
+	vec<uint64_t> closures;
+
+	static const vec<uint64_t>& buildClosures(const StructType& type, umap<const StructType*, vec<uint64_t>>& built, uint32_t& componentCount);
+	static vec<uint64_t> buildOwnClosures(const StructType& type, uint32_t& componentCount);
+};
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "instance-circuit.hpp"
+
+#include <cassert>
+
+#include "struct-type.hpp"
+
+InstanceCircuit::InstanceCircuit(const StructType& type, const uint32_t variableCount) : type(&type), variableCount(variableCount)
+{
+	nodes.reserve(2 + variableCount * 3);
+	nodes.push_back({ NodeKind::False, false, 0, 0, 0 });
+	nodes.push_back({ NodeKind::True, false, 0, 0, 0 });
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		nodes.push_back({ NodeKind::Literal, false, variable, 0, 0 });
+		nodes.push_back({ NodeKind::Literal, true, variable, 0, 0 });
+	}
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+		nodes.push_back({ NodeKind::Free, false, variable, 0, 0 });
+}
+
+uint32_t InstanceCircuit::getLiteralNode(const uint32_t variable, const bool value) const
+{
+	return 2 + variable * 2 + value;
+}
+
+uint32_t InstanceCircuit::getFreeNode(const uint32_t variable) const
+{
+	return 2 + variableCount * 2 + variable;
+}
+
+uint32_t InstanceCircuit::addAnd(const uint32_t* const nodeChildren, const uint32_t childCount)
+{
+	const uint32_t childBegin = children.size();
+	for (uint32_t i = 0; i < childCount; i++)
+	{
+		if (nodeChildren[i] == FalseNode)
+		{
+			children.resize(childBegin);
+			return FalseNode;
+		}
+		if (nodeChildren[i] != TrueNode)
+			children.push_back(nodeChildren[i]);
+	}
+	if (children.size() - childBegin <= 1)
+	{
+		const uint32_t only = children.size() == childBegin ? TrueNode : children.back();
+		children.resize(childBegin);
+		return only;
+	}
+	nodes.push_back({ NodeKind::And, false, 0, childBegin, static_cast<uint32_t>(children.size()) });
+	return nodes.size() - 1;
+}
+
+uint32_t InstanceCircuit::addDecision(const uint32_t variable, const uint32_t low, const uint32_t high)
+{
+	if (low == FalseNode && high == FalseNode)
+		return FalseNode;
+	const uint32_t childBegin = children.size();
+	children.push_back(low);
+	children.push_back(high);
+	nodes.push_back({ NodeKind::Decision, false, variable, childBegin, childBegin + 2 });
+	return nodes.size() - 1;
+}
+
+void InstanceCircuit::setRoot(const uint32_t node)
+{
+	root = node;
+}
+
+uint32_t InstanceCircuit::getVariableCount() const
+{
+	return variableCount;
+}
+
+size_t InstanceCircuit::getNodeCount() const
+{
+	return nodes.size();
+}
+
+size_t InstanceCircuit::getEdgeCount() const
+{
+	return children.size();
+}
+
+size_t InstanceCircuit::count() const
+{
+	return count(PartialAssignment(variableCount));
+}
+
+// calls the function for every promotion of the type that is not decided by the assumptions, with the assumptions projected into its target,
+// and returns the assumptions for the circuit of the type itself (all the undecided promoted properties unset)
+template <typename F>
+static PartialAssignment forEachPromotion(const vec<Promotion>& promotions, const PartialAssignment& assumptions, const F& function)
+{
+	PartialAssignment current = assumptions;
+	for (const Promotion& promotion : promotions)
+	{
+		if (current.isSpecified(promotion.property))
+			continue;
+		PartialAssignment projected;
+		if (promotion.project(current, projected))
+			function(*promotion.target, projected, promotion.propertyMap);
+		current.set(promotion.property, false);
+	}
+	return current;
+}
+
+size_t InstanceCircuit::count(const PartialAssignment& assumptions) const
+{
+	assert(assumptions.getVariableCount() == variableCount);
+	size_t total = 0;
+	const PartialAssignment own = forEachPromotion(type->promotions, assumptions, [&](const StructType& target, const PartialAssignment& projected, const vec<uint32_t>&)
+	{
+		assert(target.getCircuit());
+		total += target.getCircuit()->count(projected);
+	});
+	return total + countCircuit(own);
+}
+
+vec<size_t> InstanceCircuit::getMarginals(const PartialAssignment& assumptions) const
+{
+	assert(assumptions.getVariableCount() == variableCount);
+	vec<size_t> marginals(variableCount, 0);
+	const PartialAssignment own = forEachPromotion(type->promotions, assumptions, [&](const StructType& target, const PartialAssignment& projected, const vec<uint32_t>& propertyMap)
+	{
+		assert(target.getCircuit());
+		const vec<size_t> promotedMarginals = target.getCircuit()->getMarginals(projected);
+		for (uint32_t variable = 0; variable < variableCount; variable++)
+			marginals[variable] += promotedMarginals[propertyMap[variable]];
+	});
+	addCircuitMarginals(own, marginals);
+	return marginals;
+}
+
+size_t InstanceCircuit::countCircuit(const PartialAssignment& assumptions) const
+{
+	vec<size_t> up;
+	computeUp(assumptions, up);
+	return up[root];
+}
+
+void InstanceCircuit::computeUp(const PartialAssignment& assumptions, vec<size_t>& up) const
+{
+	up.resize(nodes.size());
+	for (uint32_t i = 0; i < nodes.size(); i++)
+	{
+		const Node& node = nodes[i];
+		switch (node.kind)
+		{
+		case NodeKind::False:
+			up[i] = 0;
+			break;
+		case NodeKind::True:
+			up[i] = 1;
+			break;
+		case NodeKind::Literal:
+			up[i] = assumptions.allows(node.variable, node.value);
+			break;
+		case NodeKind::Free:
+			up[i] = assumptions.isSpecified(node.variable) ? 1 : 2;
+			break;
+		case NodeKind::Decision:
+			up[i] = (assumptions.allows(node.variable, false) ? up[children[node.childBegin]] : 0)
+				+ (assumptions.allows(node.variable, true) ? up[children[node.childBegin + 1]] : 0);
+			break;
+		case NodeKind::And:
+			up[i] = 1;
+			for (uint32_t ci = node.childBegin; ci < node.childEnd; ci++)
+				up[i] *= up[children[ci]];
+			break;
+		}
+	}
+}
+
+void InstanceCircuit::addCircuitMarginals(const PartialAssignment& assumptions, vec<size_t>& marginals) const
+{
+	vec<size_t> up;
+	computeUp(assumptions, up);
+	// down holds the partial derivative of the root count by the node, i.e. the number of completions of its models to models of the root
+	vec<size_t> down(nodes.size(), 0);
+	down[root] = 1;
+	vec<size_t> suffix;
+	for (uint32_t i = root + 1; i-- > 0;)
+	{
+		const Node& node = nodes[i];
+		if (!down[i])
+			continue;
+		switch (node.kind)
+		{
+		case NodeKind::False:
+		case NodeKind::True:
+			break;
+		case NodeKind::Literal:
+			if (node.value && assumptions.allows(node.variable, true))
+				marginals[node.variable] += down[i];
+			break;
+		case NodeKind::Free:
+			if (assumptions.allows(node.variable, true))
+				marginals[node.variable] += down[i];
+			break;
+		case NodeKind::Decision:
+		{
+			const uint32_t low = children[node.childBegin];
+			const uint32_t high = children[node.childBegin + 1];
+			if (assumptions.allows(node.variable, false))
+				down[low] += down[i];
+			if (assumptions.allows(node.variable, true))
+			{
+				down[high] += down[i];
+				marginals[node.variable] += down[i] * up[high];
+			}
+			break;
+		}
+		case NodeKind::And:
+		{
+			// the product of the siblings is assembled from suffix products, so zero counts need no division
+			const uint32_t childCount = node.childEnd - node.childBegin;
+			suffix.assign(childCount + 1, 1);
+			for (uint32_t ci = childCount; ci-- > 0;)
+				suffix[ci] = suffix[ci + 1] * up[children[node.childBegin + ci]];
+			size_t prefix = 1;
+			for (uint32_t ci = 0; ci < childCount; ci++)
+			{
+				const uint32_t child = children[node.childBegin + ci];
+				down[child] += down[i] * prefix * suffix[ci + 1];
+				prefix *= up[child];
+			}
+			break;
+		}
+		}
+	}
+}
\ No newline at end of file
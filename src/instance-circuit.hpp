@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "partial-assignment.hpp"
+#include "vec.hpp"
+
+class StructType;
+
+// Decision-DNNF over the deep properties of a type, compiled from its flatRelations by the instance counter.
+// Nodes are stored in a flat array in which children precede their parents and the root is the last node.
+// The circuit is smooth: every model assigns every property at exactly one literal, free or decision node on its path,
+// so counting, conditioning and marginals are single passes over the array.
+// The promotions of the type are not compiled in, queries combine the circuit with the circuits of the promotion targets.
+class InstanceCircuit
+{
+public:
+	enum class NodeKind : uint8_t
+	{
+		False,
+		True,
+		Literal,
+		Free,
+		Decision,
+		And
+	};
+
+	struct Node
+	{
+		NodeKind kind;
+		bool value;
+		uint32_t variable;
+		// Decision nodes have the children (low, high), And nodes any number of children
+		uint32_t childBegin;
+		uint32_t childEnd;
+	};
+
+	static constexpr uint32_t FalseNode = 0;
+	static constexpr uint32_t TrueNode = 1;
+
+	InstanceCircuit(const StructType& type, uint32_t variableCount);
+
+	uint32_t getLiteralNode(uint32_t variable, bool value) const;
+	uint32_t getFreeNode(uint32_t variable) const;
+	// the children are simplified, so the result may be an existing node
+	uint32_t addAnd(const uint32_t* children, uint32_t childCount);
+	uint32_t addDecision(uint32_t variable, uint32_t low, uint32_t high);
+	void setRoot(uint32_t node);
+
+	uint32_t getVariableCount() const;
+	size_t getNodeCount() const;
+	size_t getEdgeCount() const;
+
+	// number of the instances of the type, the instances with a promoted property are counted by the type it promotes to
+	size_t count() const;
+	size_t count(const PartialAssignment& assumptions) const;
+	// for every property, the number of the instances in which it holds
+	vec<size_t> getMarginals(const PartialAssignment& assumptions) const;
+
+private:
+	const StructType* type;
+	uint32_t variableCount;
+	vec<Node> nodes;
+	vec<uint32_t> children;
+	uint32_t root = FalseNode;
+
+	size_t countCircuit(const PartialAssignment& assumptions) const;
+	void addCircuitMarginals(const PartialAssignment& assumptions, vec<size_t>& marginals) const;
+	void computeUp(const PartialAssignment& assumptions, vec<size_t>& up) const;
+};
\ No newline at end of file
@@ -0,0 +1,679 @@
+#include "instance-counter.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+const char* getBranchHeuristicName(const BranchHeuristic heuristic)
+{
+	switch (heuristic)
+	{
+	case BranchHeuristic::FirstIndex:
+		return "first-index";
+	case BranchHeuristic::Occurrences:
+		return "occurrences";
+	case BranchHeuristic::Activity:
+		return "activity";
+	case BranchHeuristic::MemberOrder:
+		return "member-order";
+	}
+	return "";
+}
+
+InstanceCounter::InstanceCounter(const StructType& type, const CountingOptions& options)
+	: options(options), cache(options.cacheMemoryLimit)
+{
+	assert(type.isPreprocessed());
+	root = getWorkspace(type);
+}
+
+size_t InstanceCounter::count()
+{
+	stopped = false;
+	decisionEnd = options.decisionLimit ? decisionCount + options.decisionLimit : 0;
+	return search(*root);
+}
+
+size_t InstanceCounter::count(const PartialAssignment& assumptions)
+{
+	assert(assumptions.getVariableCount() == root->variableCount);
+	for (uint32_t variable = 0; variable < root->variableCount; variable++)
+	{
+		if (assumptions.isSpecified(variable))
+			root->assign(variable, assumptions.getValue(variable));
+	}
+	return count();
+}
+
+uptr<InstanceCircuit> InstanceCounter::compile()
+{
+	// the circuit covers the relations of the type only, its promotions are applied when it is queried
+	uptr<InstanceCircuit> compiled = make_unique<InstanceCircuit>(*root->type, root->variableCount);
+	circuit = compiled.get();
+	// the circuit is only valid if the search is complete, so it is never stopped
+	stopped = false;
+	decisionEnd = 0;
+	cache.clear();
+	compiled->setRoot(search(*root));
+	cache.clear();
+	circuit = nullptr;
+	return compiled;
+}
+
+const ComponentCache& InstanceCounter::getCache() const
+{
+	return cache;
+}
+
+size_t InstanceCounter::getDecisionCount() const
+{
+	return decisionCount;
+}
+
+bool InstanceCounter::isStopped() const
+{
+	return stopped;
+}
+
+InstanceCounter::Workspace* InstanceCounter::getWorkspace(const StructType& type)
+{
+	const auto found = workspaces.find(&type);
+	if (found != workspaces.end())
+		return found->second.get();
+
+	Workspace* const ws = (workspaces[&type] = make_unique<Workspace>()).get();
+	ws->type = &type;
+	ws->id = workspaces.size() - 1;
+	ws->variableCount = type.deepPropertyGroups.size();
+	ws->specified.resize((ws->variableCount + 63) / 64, 0);
+	ws->values.resize((ws->variableCount + 63) / 64, 0);
+	// every frame and every trail entry specifies a distinct variable, so neither can outgrow the variable count
+	ws->trail.reserve(ws->variableCount);
+	ws->frames.reserve(ws->variableCount);
+	buildWatches(*ws);
+	buildHeuristic(*ws);
+
+	ws->promotions.reserve(type.promotions.size());
+	for (const Promotion& promotion : type.promotions)
+	{
+		assert(promotion.target->isPreprocessed());
+		ws->promotions.push_back({ promotion.property, getWorkspace(*promotion.target), &promotion.propertyMap });
+	}
+	return ws;
+}
+
+void InstanceCounter::buildWatches(Workspace& ws)
+{
+	vec<uint32_t> literalOccurrences(ws.variableCount * 2, 0);
+	vec<uint32_t> literals;
+	const ClauseArena& relations = ws.type->flatRelations;
+	for (uint32_t clause = 0; clause < relations.getClauseCount(); clause++)
+	{
+		literals.clear();
+		bool tautology = false;
+		for (const uint32_t literal : relations[clause])
+		{
+			if (std::find(literals.begin(), literals.end(), literal ^ 1) != literals.end())
+			{
+				tautology = true;
+				break;
+			}
+			if (std::find(literals.begin(), literals.end(), literal) == literals.end())
+				literals.push_back(literal);
+		}
+		if (tautology)
+			continue;
+		if (literals.empty())
+		{
+			ws.hasEmptyClause = true;
+			continue;
+		}
+		if (literals.size() == 1)
+		{
+			ws.unitLiterals.push_back(literals.front());
+			continue;
+		}
+		ws.clauseStarts.push_back(ws.clauseLiterals.size());
+		ws.clauseLiterals.insert(ws.clauseLiterals.end(), literals.begin(), literals.end());
+		for (const uint32_t literal : literals)
+			literalOccurrences[literal]++;
+	}
+	ws.clauseStarts.push_back(ws.clauseLiterals.size());
+
+	// a clause is watched by a literal at most once, so reserving the occurrence count keeps the watch lists from reallocating
+	ws.watches.resize(ws.variableCount * 2);
+	for (uint32_t literal = 0; literal < ws.watches.size(); literal++)
+		ws.watches[literal].reserve(literalOccurrences[literal]);
+	ws.occurrences.resize(ws.variableCount);
+	for (uint32_t variable = 0; variable < ws.variableCount; variable++)
+		ws.occurrences[variable].reserve(literalOccurrences[variable << 1] + literalOccurrences[variable << 1 | 1]);
+	for (uint32_t clause = 0; clause + 1 < ws.clauseStarts.size(); clause++)
+	{
+		ws.watches[ws.clauseLiterals[ws.clauseStarts[clause]]].push_back(clause);
+		ws.watches[ws.clauseLiterals[ws.clauseStarts[clause] + 1]].push_back(clause);
+		for (uint32_t li = ws.clauseStarts[clause]; li < ws.clauseStarts[clause + 1]; li++)
+			ws.occurrences[ws.clauseLiterals[li] >> 1].push_back(clause);
+	}
+
+	ws.variableStamps.resize(ws.variableCount, 0);
+	ws.clauseStamps.resize(ws.clauseStarts.size() - 1, 0);
+	// the root component holds every variable, each split stores at most the variables of the component it splits
+	ws.componentVariables.reserve(ws.variableCount * 2);
+	ws.componentClauses.reserve((ws.clauseStarts.size() - 1) * 2);
+	ws.key.words.reserve(ws.variableCount + ws.clauseStarts.size() + 1);
+	ws.assumptionKey.words.reserve(ws.specified.size() * 4 + 1);
+	ws.freeVariables.reserve(ws.variableCount);
+}
+
+void InstanceCounter::buildHeuristic(Workspace& ws) const
+{
+	if (options.branchHeuristic == BranchHeuristic::Occurrences)
+		ws.scores.resize(ws.variableCount, 0);
+	else if (options.branchHeuristic == BranchHeuristic::Activity)
+	{
+		ws.activity.resize(ws.variableCount);
+		for (uint32_t variable = 0; variable < ws.variableCount; variable++)
+			ws.activity[variable] = ws.occurrences[variable].size();
+	}
+	else if (options.branchHeuristic == BranchHeuristic::MemberOrder)
+	{
+		// a property stands for as many deep properties as the paths leading to it,
+		// the properties reachable by many paths tie the members together, so deciding them first lets the rest split
+		umap<const StructType*, vec<uint32_t>> pathCounts;
+		const auto& countPaths = [&](const StructType& type, const auto& countPathsFun) -> const vec<uint32_t>&
+		{
+			const auto found = pathCounts.find(&type);
+			if (found != pathCounts.end())
+				return found->second;
+			vec<uint32_t> counts(type.deepPropertyGroups.size(), 0);
+			for (uint32_t variable = 0; variable < counts.size(); variable++)
+			{
+				for (const pair<uint32_t, uint32_t>& entry : type.deepPropertyGroups[variable])
+					counts[variable] += entry.first ? countPathsFun(*type.members[entry.first - 1].second, countPathsFun)[entry.second] : 1;
+			}
+			return pathCounts[&type] = std::move(counts);
+		};
+		const vec<uint32_t>& counts = countPaths(*ws.type, countPaths);
+		vec<uint32_t> order(ws.variableCount);
+		for (uint32_t variable = 0; variable < ws.variableCount; variable++)
+			order[variable] = variable;
+		std::stable_sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) { return counts[a] > counts[b]; });
+		ws.staticRank.resize(ws.variableCount);
+		for (uint32_t rank = 0; rank < ws.variableCount; rank++)
+			ws.staticRank[order[rank]] = rank;
+	}
+}
+
+bool InstanceCounter::Workspace::isClauseSatisfied(const uint32_t clause) const
+{
+	for (uint32_t li = clauseStarts[clause]; li < clauseStarts[clause + 1]; li++)
+		if (isLiteralTrue(clauseLiterals[li]))
+			return true;
+	return false;
+}
+
+uint32_t InstanceCounter::Workspace::nextStamp()
+{
+	if (++stamp == 0)
+	{
+		std::fill(variableStamps.begin(), variableStamps.end(), 0);
+		std::fill(clauseStamps.begin(), clauseStamps.end(), 0);
+		stamp = 1;
+	}
+	return stamp;
+}
+
+size_t InstanceCounter::search(Workspace& ws)
+{
+	// the promotion chains only lead to strictly larger types, so a workspace is never entered twice
+	assert(!ws.busy);
+	ws.busy = true;
+
+	// the residual formula is counted as a product over its independent components,
+	// each of which is counted as the sum over the two values of a branch variable;
+	// when compiling, the results are circuit nodes instead of counts (the false node and the zero count coincide)
+	enum class Step
+	{
+		Promote,
+		Decompose,
+		Branch,
+		Return
+	};
+
+	// the variables of a conflicting clause are bumped for the activity heuristic
+	const auto& propagateBranch = [this, &ws]()
+	{
+		const uint32_t conflict = propagate(ws);
+		if (conflict != NoConflict && conflict != UnitConflict && options.branchHeuristic == BranchHeuristic::Activity)
+			bumpConflict(ws, conflict);
+		return conflict == NoConflict;
+	};
+
+	Step step = Step::Promote;
+	size_t result = 0;
+	uint32_t component = 0;
+	// the first trail entry implied in the current branch
+	uint32_t branchStart = 0;
+	while (true)
+	{
+		if (stopped)
+		{
+			// the partial results are dropped, so nothing computed after the limit is cached
+			ws.frames.clear();
+			ws.components.clear();
+			ws.componentVariables.clear();
+			ws.componentClauses.clear();
+			ws.nodeStack.clear();
+			result = 0;
+			break;
+		}
+		if (step == Step::Promote)
+		{
+			const PromotionTarget* promotion = nullptr;
+			for (const PromotionTarget& target : ws.promotions)
+			{
+				if (!circuit && !ws.isSpecified(target.variable))
+				{
+					promotion = &target;
+					break;
+				}
+			}
+			if (promotion)
+			{
+				// instances with the property set are counted as the instances of the type it promotes to
+				const size_t promotedCount = countPromoted(ws, *promotion);
+				ws.frames.push_back(Frame(FrameKind::Promotion, promotion->variable, ws.trail.size(), 0, promotedCount));
+				ws.assign(promotion->variable, false);
+				continue;
+			}
+			if (!propagateBranch())
+			{
+				result = 0;
+				step = Step::Return;
+				continue;
+			}
+			ws.componentVariables.clear();
+			ws.componentClauses.clear();
+			ws.components.clear();
+			for (uint32_t variable = 0; variable < ws.variableCount; variable++)
+				ws.componentVariables.push_back(variable);
+			ws.components.push_back({ 0, ws.variableCount, 0, 0 });
+			component = 0;
+			branchStart = 0;
+			step = Step::Decompose;
+			continue;
+		}
+		if (step == Step::Decompose)
+		{
+			const uint32_t firstComponent = ws.components.size();
+			const uint32_t nodeBase = ws.nodeStack.size();
+			if (circuit)
+			{
+				for (uint32_t ti = branchStart; ti < ws.trail.size(); ti++)
+					ws.nodeStack.push_back(circuit->getLiteralNode(ws.trail[ti], ws.getValue(ws.trail[ti])));
+			}
+			size_t freeFactor = 1;
+			const bool split = decompose(ws, ws.components[component].begin, ws.components[component].end, freeFactor);
+			if (circuit)
+			{
+				for (const uint32_t variable : ws.freeVariables)
+					ws.nodeStack.push_back(circuit->getFreeNode(variable));
+			}
+			if (!split)
+			{
+				result = circuit ? addAnd(ws, nodeBase) : freeFactor;
+				step = Step::Return;
+				continue;
+			}
+			ws.frames.push_back(Frame(FrameKind::Split, NoVariable, ws.trail.size(), firstComponent, circuit ? nodeBase : freeFactor));
+			component = ws.frames.back().nextComponent++;
+			step = Step::Branch;
+			continue;
+		}
+		if (step == Step::Branch)
+		{
+			if (options.cacheComponents)
+			{
+				buildKey(ws, ws.components[component]);
+				if (cache.find(ws.key, result))
+				{
+					step = Step::Return;
+					continue;
+				}
+			}
+			const uint32_t variable = pickBranchVariable(ws, ws.components[component]);
+			decisionCount++;
+			if (decisionCount == decisionEnd)
+				stopped = true;
+			ws.frames.push_back(Frame(FrameKind::Decision, variable, ws.trail.size(), component, 0));
+			ws.assign(variable, false);
+			branchStart = ws.trail.size();
+			if (propagateBranch())
+			{
+				step = Step::Decompose;
+				continue;
+			}
+			result = 0;
+			step = Step::Return;
+			continue;
+		}
+
+		if (ws.frames.empty())
+			break;
+		Frame& frame = ws.frames.back();
+		if (frame.kind == FrameKind::Split)
+		{
+			bool satisfiable;
+			if (circuit)
+			{
+				ws.nodeStack.push_back(result);
+				satisfiable = result != InstanceCircuit::FalseNode;
+			}
+			else
+			{
+				frame.count *= result;
+				satisfiable = frame.count != 0;
+			}
+			if (satisfiable && frame.nextComponent < ws.components.size())
+			{
+				component = frame.nextComponent++;
+				step = Step::Branch;
+				continue;
+			}
+			ws.componentVariables.resize(ws.components[frame.component].begin);
+			ws.componentClauses.resize(ws.components[frame.component].clauseBegin);
+			ws.components.resize(frame.component);
+			result = circuit ? addAnd(ws, frame.count) : frame.count;
+			ws.frames.pop_back();
+			continue;
+		}
+		ws.undo(frame.trailSize);
+		if (frame.kind == FrameKind::Decision && !frame.secondBranch)
+		{
+			frame.count = result;
+			frame.secondBranch = true;
+			component = frame.component;
+			ws.assign(frame.variable, true);
+			branchStart = ws.trail.size();
+			if (propagateBranch())
+			{
+				step = Step::Decompose;
+				continue;
+			}
+			result = 0;
+			continue;
+		}
+		if (frame.kind == FrameKind::Decision && circuit)
+			result = circuit->addDecision(frame.variable, frame.count, result);
+		else
+			result += frame.count;
+		if (frame.kind == FrameKind::Decision && options.cacheComponents)
+		{
+			buildKey(ws, ws.components[frame.component]);
+			cache.insert(ws.key, result);
+		}
+		ws.frames.pop_back();
+	}
+
+	ws.undo(0);
+	ws.busy = false;
+	return result;
+}
+
+size_t InstanceCounter::addAnd(Workspace& ws, const uint32_t nodeBase)
+{
+	const uint32_t node = circuit->addAnd(ws.nodeStack.data() + nodeBase, ws.nodeStack.size() - nodeBase);
+	ws.nodeStack.resize(nodeBase);
+	return node;
+}
+
+size_t InstanceCounter::countPromoted(const Workspace& ws, const PromotionTarget& promotion)
+{
+	Workspace& target = *promotion.workspace;
+	for (const uint32_t variable : ws.trail)
+	{
+		const uint32_t promotedVariable = (*promotion.propertyMap)[variable];
+		// properties distinct in this type may be equal in the type it promotes to
+		if (target.isSpecified(promotedVariable))
+		{
+			if (target.getValue(promotedVariable) != ws.getValue(variable))
+			{
+				target.undo(0);
+				return 0;
+			}
+			continue;
+		}
+		target.assign(promotedVariable, ws.getValue(variable));
+	}
+	if (!options.cacheComponents)
+		return search(target);
+	// the count of the target only depends on the projected assignment, which recurs across the queries and along the promotion chains
+	buildAssumptionKey(target);
+	size_t count;
+	if (cache.find(target.assumptionKey, count))
+	{
+		target.undo(0);
+		return count;
+	}
+	count = search(target);
+	if (!stopped)
+		cache.insert(target.assumptionKey, count);
+	return count;
+}
+
+uint32_t InstanceCounter::propagate(Workspace& ws) const
+{
+	if (ws.hasEmptyClause)
+		return UnitConflict;
+	for (const uint32_t literal : ws.unitLiterals)
+	{
+		if (ws.isLiteralFalse(literal))
+			return UnitConflict;
+		if (!ws.isLiteralTrue(literal))
+			ws.assign(literal >> 1, !(literal & 1));
+	}
+	while (ws.propagationHead < ws.trail.size())
+	{
+		const uint32_t variable = ws.trail[ws.propagationHead++];
+		const uint32_t falseLiteral = variable << 1 | ws.getValue(variable);
+		vec<uint32_t>& watchers = ws.watches[falseLiteral];
+		uint32_t kept = 0;
+		for (uint32_t wi = 0; wi < watchers.size(); wi++)
+		{
+			const uint32_t clause = watchers[wi];
+			uint32_t* const literals = &ws.clauseLiterals[ws.clauseStarts[clause]];
+			const uint32_t size = ws.clauseStarts[clause + 1] - ws.clauseStarts[clause];
+			if (literals[0] == falseLiteral)
+				std::swap(literals[0], literals[1]);
+			if (ws.isLiteralTrue(literals[0]))
+			{
+				watchers[kept++] = clause;
+				continue;
+			}
+			bool moved = false;
+			for (uint32_t li = 2; li < size; li++)
+			{
+				if (!ws.isLiteralFalse(literals[li]))
+				{
+					std::swap(literals[1], literals[li]);
+					ws.watches[literals[1]].push_back(clause);
+					moved = true;
+					break;
+				}
+			}
+			if (moved)
+				continue;
+			watchers[kept++] = clause;
+			if (ws.isLiteralFalse(literals[0]))
+			{
+				// keep the remaining watchers, the conflict is resolved by backtracking
+				for (wi++; wi < watchers.size(); wi++)
+					watchers[kept++] = watchers[wi];
+				watchers.resize(kept);
+				return clause;
+			}
+			ws.assign(literals[0] >> 1, !(literals[0] & 1));
+		}
+		watchers.resize(kept);
+	}
+	return NoConflict;
+}
+
+bool InstanceCounter::decompose(Workspace& ws, const uint32_t begin, const uint32_t end, size_t& freeFactor) const
+{
+	// splits the unspecified variables of a component into the connected components of its unsatisfied clauses,
+	// the variables that occur in no unsatisfied clause are free and only contribute the factor of 2
+	const uint32_t stamp = ws.nextStamp();
+	ws.freeVariables.clear();
+	bool found = false;
+	for (uint32_t vi = begin; vi < end; vi++)
+	{
+		const uint32_t seed = ws.componentVariables[vi];
+		if (ws.isSpecified(seed) || ws.variableStamps[seed] == stamp)
+			continue;
+		ws.variableStamps[seed] = stamp;
+		const uint32_t componentBegin = ws.componentVariables.size();
+		const uint32_t clauseBegin = ws.componentClauses.size();
+		ws.componentVariables.push_back(seed);
+		bool constrained = false;
+		for (uint32_t qi = componentBegin; qi < ws.componentVariables.size(); qi++)
+		{
+			const uint32_t variable = ws.componentVariables[qi];
+			for (const uint32_t clause : ws.occurrences[variable])
+			{
+				if (ws.clauseStamps[clause] == stamp)
+				{
+					constrained = true;
+					continue;
+				}
+				if (ws.isClauseSatisfied(clause))
+					continue;
+				constrained = true;
+				ws.clauseStamps[clause] = stamp;
+				ws.componentClauses.push_back(clause);
+				for (uint32_t li = ws.clauseStarts[clause]; li < ws.clauseStarts[clause + 1]; li++)
+				{
+					const uint32_t neighbor = ws.clauseLiterals[li] >> 1;
+					if (!ws.isSpecified(neighbor) && ws.variableStamps[neighbor] != stamp)
+					{
+						ws.variableStamps[neighbor] = stamp;
+						ws.componentVariables.push_back(neighbor);
+					}
+				}
+			}
+		}
+		if (!constrained)
+		{
+			ws.componentVariables.pop_back();
+			ws.freeVariables.push_back(seed);
+			freeFactor *= 2;
+			continue;
+		}
+		ws.components.push_back({ componentBegin, static_cast<uint32_t>(ws.componentVariables.size()), clauseBegin, static_cast<uint32_t>(ws.componentClauses.size()) });
+		found = true;
+	}
+	return found;
+}
+
+uint32_t InstanceCounter::pickBranchVariable(Workspace& ws, const Component& component) const
+{
+	// ties go to the lowest index, so that the choice does not depend on the order of the component variables
+	uint32_t best = NoVariable;
+	if (options.branchHeuristic == BranchHeuristic::FirstIndex)
+	{
+		for (uint32_t vi = component.begin; vi < component.end; vi++)
+		{
+			const uint32_t variable = ws.componentVariables[vi];
+			if (!ws.isSpecified(variable) && variable < best)
+				best = variable;
+		}
+	}
+	else if (options.branchHeuristic == BranchHeuristic::Occurrences)
+	{
+		// the clauses and variables of a component were collected by its decomposition, so they are all unsatisfied and unspecified
+		for (uint32_t ci = component.clauseBegin; ci < component.clauseEnd; ci++)
+		{
+			const uint32_t clause = ws.componentClauses[ci];
+			for (uint32_t li = ws.clauseStarts[clause]; li < ws.clauseStarts[clause + 1]; li++)
+			{
+				if (!ws.isSpecified(ws.clauseLiterals[li] >> 1))
+					ws.scores[ws.clauseLiterals[li] >> 1]++;
+			}
+		}
+		uint32_t bestScore = 0;
+		for (uint32_t vi = component.begin; vi < component.end; vi++)
+		{
+			const uint32_t variable = ws.componentVariables[vi];
+			const uint32_t score = ws.scores[variable];
+			ws.scores[variable] = 0;
+			if (best == NoVariable || score > bestScore || (score == bestScore && variable < best))
+			{
+				best = variable;
+				bestScore = score;
+			}
+		}
+	}
+	else if (options.branchHeuristic == BranchHeuristic::Activity)
+	{
+		for (uint32_t vi = component.begin; vi < component.end; vi++)
+		{
+			const uint32_t variable = ws.componentVariables[vi];
+			if (best == NoVariable || ws.activity[variable] > ws.activity[best] || (ws.activity[variable] == ws.activity[best] && variable < best))
+				best = variable;
+		}
+	}
+	else
+	{
+		for (uint32_t vi = component.begin; vi < component.end; vi++)
+		{
+			const uint32_t variable = ws.componentVariables[vi];
+			if (best == NoVariable || ws.staticRank[variable] < ws.staticRank[best])
+				best = variable;
+		}
+	}
+	return best;
+}
+
+void InstanceCounter::bumpConflict(Workspace& ws, const uint32_t clause)
+{
+	for (uint32_t li = ws.clauseStarts[clause]; li < ws.clauseStarts[clause + 1]; li++)
+		ws.activity[ws.clauseLiterals[li] >> 1] += ws.activityIncrement;
+	// growing the increment decays the older bumps
+	ws.activityIncrement /= 0.95;
+	if (ws.activityIncrement > 1e100)
+	{
+		for (double& activity : ws.activity)
+			activity *= 1e-100;
+		ws.activityIncrement *= 1e-100;
+	}
+}
+
+void InstanceCounter::buildKey(Workspace& ws, const Component& component)
+{
+	// the unsatisfied clauses restricted to the unspecified variables determine the residual formula,
+	// so the variables together with the clause indices identify it within the workspace
+	vec<uint32_t>& words = ws.key.words;
+	words.clear();
+	words.push_back(ws.id);
+	words.push_back(component.end - component.begin);
+	words.insert(words.end(), ws.componentVariables.begin() + component.begin, ws.componentVariables.begin() + component.end);
+	std::sort(words.begin() + 2, words.end());
+	const size_t clausesStart = words.size();
+	words.insert(words.end(), ws.componentClauses.begin() + component.clauseBegin, ws.componentClauses.begin() + component.clauseEnd);
+	std::sort(words.begin() + clausesStart, words.end());
+}
+
+void InstanceCounter::buildAssumptionKey(Workspace& ws)
+{
+	// the values of the unspecified variables are stale, so they are masked out
+	vec<uint32_t>& words = ws.assumptionKey.words;
+	words.clear();
+	words.push_back(AssumptionKeyTag | ws.id);
+	for (uint32_t wi = 0; wi < ws.specified.size(); wi++)
+	{
+		const uint64_t values = ws.values[wi] & ws.specified[wi];
+		words.push_back(ws.specified[wi]);
+		words.push_back(ws.specified[wi] >> 32);
+		words.push_back(values);
+		words.push_back(values >> 32);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <limits>
+
+#include "component-cache.hpp"
+#include "instance-circuit.hpp"
+#include "ptr.hpp"
+#include "umap.hpp"
+#include "vec.hpp"
+
+#include "struct-type.hpp"
+
+// how the counter picks the property to branch on within a component
+enum class BranchHeuristic
+{
+	// the property with the lowest flat index
+	FirstIndex,
+	// the property with the most occurrences in the unsatisfied clauses of the component
+	Occurrences,
+	// the property that took part in the most (decayed) conflicts, seeded with its occurrence count
+	Activity,
+	// a fixed order that decides the properties shared by the most members first
+	MemberOrder
+};
+
+struct CountingOptions
+{
+	// memoize the counts of the residual components
+	bool cacheComponents = true;
+	size_t cacheMemoryLimit = size_t(64) << 20;
+	BranchHeuristic branchHeuristic = BranchHeuristic::Occurrences;
+	// stops a count after this many decisions, 0 for no limit; the result of a stopped count is not valid
+	size_t decisionLimit = 0;
+};
+
+const char* getBranchHeuristicName(BranchHeuristic heuristic);
+
+// Counts the possible instances of a preprocessed type.
+// The search keeps a single packed assignment per type together with an undo trail and an explicit stack of branch frames,
+// so it backtracks in place, does not recurse over the properties and does not allocate once the workspaces are built.
+class InstanceCounter
+{
+public:
+	InstanceCounter(const StructType& type, const CountingOptions& options = CountingOptions());
+
+	size_t count();
+	// counts the instances that agree with the assumptions
+	size_t count(const PartialAssignment& assumptions);
+	// compiles the relations of the type into a decision-DNNF by tracing the search
+	uptr<InstanceCircuit> compile();
+
+	const ComponentCache& getCache() const;
+	// the number of branch decisions made by all the searches of this counter
+	size_t getDecisionCount() const;
+	// whether the last count reached the decision limit
+	bool isStopped() const;
+
+private:
+	static constexpr uint32_t NoVariable = std::numeric_limits<uint32_t>::max();
+	// the results of propagate besides the index of the conflicting clause
+	static constexpr uint32_t NoConflict = std::numeric_limits<uint32_t>::max();
+	static constexpr uint32_t UnitConflict = NoConflict - 1;
+	// marks the keys of the promoted counts, which share the cache with the component counts
+	static constexpr uint32_t AssumptionKeyTag = uint32_t(1) << 31;
+
+	enum class FrameKind
+	{
+		Decision,
+		Promotion,
+		Split
+	};
+
+	struct Frame
+	{
+		FrameKind kind;
+		bool secondBranch;
+		uint32_t variable;
+		uint32_t trailSize;
+		// the component a decision branches in, or the first of the independent components of a split
+		uint32_t component;
+		uint32_t nextComponent;
+		size_t count;
+
+		Frame(const FrameKind kind, const uint32_t variable, const uint32_t trailSize, const uint32_t component, const size_t count)
+			: kind(kind), secondBranch(false), variable(variable), trailSize(trailSize), component(component), nextComponent(component), count(count)
+		{
+		}
+	};
+
+	// a range of componentVariables and a range of componentClauses
+	struct Component
+	{
+		uint32_t begin;
+		uint32_t end;
+		uint32_t clauseBegin;
+		uint32_t clauseEnd;
+	};
+
+	struct Workspace;
+
+	struct PromotionTarget
+	{
+		uint32_t variable;
+		Workspace* workspace;
+		// maps the deep properties of the promoted type to the deep properties of the type it promotes to
+		const vec<uint32_t>* propertyMap;
+	};
+
+	struct Workspace
+	{
+		const StructType* type;
+		uint32_t id;
+		uint32_t variableCount;
+
+		vec<uint64_t> specified;
+		vec<uint64_t> values;
+		vec<uint32_t> trail;
+		vec<Frame> frames;
+
+		vec<PromotionTarget> promotions;
+
+		// clause literals are encoded as (property index << 1 | negated), the first two literals of a clause are the watched ones
+		vec<uint32_t> clauseLiterals;
+		vec<uint32_t> clauseStarts;
+		vec<uint32_t> unitLiterals;
+		bool hasEmptyClause = false;
+		// for every literal, the clauses in which it is watched
+		vec<vec<uint32_t>> watches;
+		uint32_t propagationHead = 0;
+		// for every property, the (non-unit) clauses it occurs in
+		vec<vec<uint32_t>> occurrences;
+
+		// the scratch scores of the occurrence heuristic, zero between the decisions
+		vec<uint32_t> scores;
+		vec<double> activity;
+		double activityIncrement = 1;
+		// the position of every property in the member order
+		vec<uint32_t> staticRank;
+
+		// stack of the components that are being counted, the variables of a split follow the variables of the component it splits
+		vec<Component> components;
+		vec<uint32_t> componentVariables;
+		vec<uint32_t> componentClauses;
+		ComponentKey key;
+		ComponentKey assumptionKey;
+		vec<uint32_t> variableStamps;
+		vec<uint32_t> clauseStamps;
+		uint32_t stamp = 0;
+		// the variables found free by the last decomposition
+		vec<uint32_t> freeVariables;
+		// the children of the circuit nodes that are being built
+		vec<uint32_t> nodeStack;
+
+		bool busy = false;
+
+		bool isSpecified(const uint32_t variable) const
+		{
+			return (specified[variable >> 6] >> (variable & 63)) & 1;
+		}
+
+		bool getValue(const uint32_t variable) const
+		{
+			return (values[variable >> 6] >> (variable & 63)) & 1;
+		}
+
+		void assign(const uint32_t variable, const bool value)
+		{
+			const uint64_t bit = uint64_t(1) << (variable & 63);
+			specified[variable >> 6] |= bit;
+			if (value)
+				values[variable >> 6] |= bit;
+			else
+				values[variable >> 6] &= ~bit;
+			trail.push_back(variable);
+		}
+
+		void undo(const uint32_t trailSize)
+		{
+			while (trail.size() > trailSize)
+			{
+				const uint32_t variable = trail.back();
+				specified[variable >> 6] &= ~(uint64_t(1) << (variable & 63));
+				trail.pop_back();
+			}
+			if (propagationHead > trailSize)
+				propagationHead = trailSize;
+		}
+
+		bool isLiteralFalse(const uint32_t literal) const
+		{
+			return isSpecified(literal >> 1) && getValue(literal >> 1) == (literal & 1);
+		}
+
+		bool isLiteralTrue(const uint32_t literal) const
+		{
+			return isSpecified(literal >> 1) && getValue(literal >> 1) != (literal & 1);
+		}
+
+		uint32_t getClauseSize(const uint32_t clause) const
+		{
+			return clauseStarts[clause + 1] - clauseStarts[clause];
+		}
+
+		bool isClauseSatisfied(const uint32_t clause) const;
+		uint32_t nextStamp();
+	};
+
+	CountingOptions options;
+	umap<const StructType*, uptr<Workspace>> workspaces;
+	Workspace* root;
+	ComponentCache cache;
+	InstanceCircuit* circuit = nullptr;
+	size_t decisionCount = 0;
+	// the decision count at which the current count stops
+	size_t decisionEnd = 0;
+	bool stopped = false;
+
+	Workspace* getWorkspace(const StructType& type);
+	static void buildWatches(Workspace& ws);
+	void buildHeuristic(Workspace& ws) const;
+
+	size_t search(Workspace& ws);
+	size_t addAnd(Workspace& ws, uint32_t nodeBase);
+	size_t countPromoted(const Workspace& ws, const PromotionTarget& promotion);
+	// returns the clause that became false, UnitConflict for a false unit or empty clause, or NoConflict
+	uint32_t propagate(Workspace& ws) const;
+	bool decompose(Workspace& ws, uint32_t begin, uint32_t end, size_t& freeFactor) const;
+	uint32_t pickBranchVariable(Workspace& ws, const Component& component) const;
+	static void bumpConflict(Workspace& ws, uint32_t clause);
+	static void buildKey(Workspace& ws, const Component& component);
+	static void buildAssumptionKey(Workspace& ws);
+};
\ No newline at end of file
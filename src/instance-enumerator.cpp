@@ -0,0 +1,194 @@
+#include "instance-enumerator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+InstanceEnumerator::InstanceEnumerator(const StructType& type, const EnumerationOptions& options)
+	: InstanceEnumerator(type, PartialAssignment(type.getDeepPropertyDistinctCount()), options)
+{
+}
+
+InstanceEnumerator::InstanceEnumerator(const StructType& type, const PartialAssignment& assumptions, const EnumerationOptions& options)
+	: options(options)
+{
+	assert(type.isPreprocessed());
+	assert(assumptions.getVariableCount() == type.getDeepPropertyDistinctCount());
+	collectTerms(type, assumptions);
+	for (const Term& term : terms)
+	{
+		if (std::find(types.begin(), types.end(), term.type) == types.end())
+			types.push_back(term.type);
+	}
+}
+
+const vec<const StructType*>& InstanceEnumerator::getTypes() const
+{
+	return types;
+}
+
+const EnumerationOptions& InstanceEnumerator::getOptions() const
+{
+	return options;
+}
+
+void InstanceEnumerator::collectTerms(const StructType& type, PartialAssignment assumptions)
+{
+	// the instances with a promoted property are the instances of the type it promotes to,
+	// the instances of the type itself have all the promoted properties false
+	for (const Promotion& promotion : type.getPromotions())
+	{
+		if (assumptions.isSpecified(promotion.property))
+			continue;
+		PartialAssignment projected;
+		const bool consistent = promotion.project(assumptions, projected);
+		if (consistent)
+			collectTerms(*promotion.target, projected);
+		assumptions.set(promotion.property, false);
+	}
+	terms.push_back({ &type, assumptions });
+}
+
+bool InstanceEnumerator::next(EnumeratedInstance& instance)
+{
+	while (true)
+	{
+		if (step == Step::Start)
+		{
+			if (termIndex == terms.size())
+				return false;
+			const StructType& type = *terms[termIndex].type;
+			propagator.load(type.flatRelations, type.getDeepPropertyDistinctCount());
+			frames.clear();
+			step = propagator.assume(terms[termIndex].assumptions) ? Step::Descend : Step::Backtrack;
+			continue;
+		}
+		if (step == Step::Descend)
+		{
+			if (!propagator.propagate())
+			{
+				step = Step::Backtrack;
+				continue;
+			}
+			const uint32_t branchVariable = propagator.pickBranchVariable();
+			if (branchVariable != ClausePropagator::NoVariable)
+			{
+				frames.push_back({ branchVariable, uint32_t(propagator.getTrail().size()), false });
+				propagator.assign(branchVariable, false);
+				continue;
+			}
+			// every clause is satisfied, so the unassigned properties are don't-cares
+			freeVariables.clear();
+			for (uint32_t variable = 0; variable < propagator.getVariableCount(); variable++)
+			{
+				if (propagator.getValue(variable) == ClausePropagator::Unset)
+					freeVariables.push_back(variable);
+			}
+			freeValues.assign(freeVariables.size(), 0);
+			step = options.cubes ? Step::Backtrack : Step::Expand;
+			fill(instance);
+			return true;
+		}
+		if (step == Step::Expand)
+		{
+			// the next full assignment of the cube, counting through the free properties in binary
+			uint32_t fi = 0;
+			while (fi < freeValues.size() && freeValues[fi])
+				freeValues[fi++] = 0;
+			if (fi < freeValues.size())
+			{
+				freeValues[fi] = 1;
+				fill(instance);
+				return true;
+			}
+			step = Step::Backtrack;
+			continue;
+		}
+		if (backtrack())
+			step = Step::Descend;
+		else
+		{
+			termIndex++;
+			step = Step::Start;
+		}
+	}
+}
+
+bool InstanceEnumerator::backtrack()
+{
+	while (!frames.empty() && frames.back().secondBranch)
+		frames.pop_back();
+	if (frames.empty())
+	{
+		propagator.undo(0);
+		return false;
+	}
+	Frame& frame = frames.back();
+	propagator.undo(frame.trailSize);
+	frame.secondBranch = true;
+	propagator.assign(frame.variable, true);
+	return true;
+}
+
+void InstanceEnumerator::fill(EnumeratedInstance& instance) const
+{
+	instance.type = terms[termIndex].type;
+	const uint32_t variableCount = propagator.getVariableCount();
+	if (instance.assignment.getVariableCount() != variableCount)
+		instance.assignment = PartialAssignment(variableCount);
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		if (propagator.getValue(variable) != ClausePropagator::Unset)
+			instance.assignment.set(variable, propagator.getValue(variable));
+		else
+			instance.assignment.unset(variable);
+	}
+	if (!options.cubes)
+	{
+		for (uint32_t fi = 0; fi < freeVariables.size(); fi++)
+			instance.assignment.set(freeVariables[fi], freeValues[fi]);
+	}
+}
+
+size_t writeInstances(InstanceEnumerator& enumerator, std::ostream& output)
+{
+	const auto& writeWord = [&output](const uint32_t word)
+	{
+		const char bytes[4] = { char(word), char(word >> 8), char(word >> 16), char(word >> 24) };
+		output.write(bytes, 4);
+	};
+	// the packed words of an assignment are cut into bytes, so that the records do not depend on the word size
+	vec<char> bytes;
+	const auto& writeBits = [&output, &bytes](const vec<uint64_t>& words, const uint32_t bitCount)
+	{
+		bytes.resize((bitCount + 7) / 8);
+		for (uint32_t bi = 0; bi < bytes.size(); bi++)
+			bytes[bi] = char(words[bi >> 3] >> ((bi & 7) * 8));
+		output.write(bytes.data(), bytes.size());
+	};
+
+	const vec<const StructType*>& types = enumerator.getTypes();
+	output.write("SINS", 4);
+	writeWord(1);
+	writeWord(enumerator.getOptions().cubes);
+	writeWord(types.size());
+	for (const StructType* type : types)
+	{
+		const str name = type->getName();
+		writeWord(name.size());
+		output.write(name.data(), name.size());
+		writeWord(type->getDeepPropertyDistinctCount());
+	}
+
+	EnumeratedInstance instance;
+	size_t count = 0;
+	while (enumerator.next(instance))
+	{
+		writeWord(std::find(types.begin(), types.end(), instance.type) - types.begin());
+		const uint32_t variableCount = instance.assignment.getVariableCount();
+		if (enumerator.getOptions().cubes)
+			writeBits(instance.assignment.getSpecifiedWords(), variableCount);
+		writeBits(instance.assignment.getValueWords(), variableCount);
+		count++;
+	}
+	return count;
+}
\ No newline at end of file
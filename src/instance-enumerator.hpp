@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "clause-propagator.hpp"
+#include "partial-assignment.hpp"
+#include "struct-type.hpp"
+#include "vec.hpp"
+
+struct EnumerationOptions
+{
+	// emit cubes in which the unspecified properties are don't-cares instead of the full assignments
+	bool cubes = false;
+};
+
+// An instance of the enumerated type or, if it has a promoted property, of the type the property promotes to.
+struct EnumeratedInstance
+{
+	const StructType* type = nullptr;
+	// over the deep properties of the type, fully specified unless cubes are enumerated
+	PartialAssignment assignment;
+};
+
+// Streams the instances of a preprocessed type one at a time.
+// The promotion chain is expanded as in the counter and every type in it is searched with a single assignment and an undo trail,
+// so the memory does not depend on the number of instances. The cubes are disjoint and their full assignments are exactly
+// the instances, so the number of instances enumerated is getPossibleInstancesCount.
+class InstanceEnumerator
+{
+public:
+	InstanceEnumerator(const StructType& type, const EnumerationOptions& options = EnumerationOptions());
+	// enumerates the instances that agree with the assumptions
+	InstanceEnumerator(const StructType& type, const PartialAssignment& assumptions, const EnumerationOptions& options = EnumerationOptions());
+
+	// returns false once all the instances were enumerated
+	bool next(EnumeratedInstance& instance);
+
+	// the types the instances may be of, in the order they are enumerated
+	const vec<const StructType*>& getTypes() const;
+	const EnumerationOptions& getOptions() const;
+
+private:
+	struct Term
+	{
+		const StructType* type;
+		PartialAssignment assumptions;
+	};
+
+	struct Frame
+	{
+		uint32_t variable;
+		uint32_t trailSize;
+		bool secondBranch;
+	};
+
+	enum class Step
+	{
+		Start,
+		Descend,
+		Expand,
+		Backtrack
+	};
+
+	EnumerationOptions options;
+	vec<Term> terms;
+	vec<const StructType*> types;
+	uint32_t termIndex = 0;
+	Step step = Step::Start;
+
+	// the search over the type of the current term
+	ClausePropagator propagator;
+	vec<Frame> frames;
+	// the properties left free by the current cube with their values, which are counted through when the full assignments are enumerated
+	vec<uint32_t> freeVariables;
+	vec<uint8_t> freeValues;
+
+	void collectTerms(const StructType& type, PartialAssignment assumptions);
+	bool backtrack();
+	void fill(EnumeratedInstance& instance) const;
+};
+
+// Writes the instances as a bit-packed binary stream and returns their number.
+// The header is the magic "SINS", the format version, the cube flag and the list of the types (name and property count),
+// every record is the index of its type followed by the bytes of the property values, preceded by the bytes of the specified
+// properties if cubes are written; all integers are 32-bit little-endian.
+size_t writeInstances(InstanceEnumerator& enumerator, std::ostream& output);
\ No newline at end of file
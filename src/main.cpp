@@ -1,24 +1,334 @@
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
 
+#include "approximate-counter.hpp"
+#include "consistency-oracle.hpp"
+#include "coverage-analyzer.hpp"
+#include "instance-enumerator.hpp"
+#include "mapped-file.hpp"
+#include "parallel-counter.hpp"
 #include "parse-utils.hpp"
 #include "parser.hpp"
 #include "print.hpp"
 
-int main()
+// counts every type with every branch heuristic, printing the decisions and the time each one takes
+void benchmarkHeuristics(const Universe& universe)
 {
+	const BranchHeuristic heuristics[] = { BranchHeuristic::FirstIndex, BranchHeuristic::Occurrences, BranchHeuristic::Activity, BranchHeuristic::MemberOrder };
+	vec<double> totals(std::size(heuristics), 0);
+	for (const auto& tp : universe.getTypes())
+	{
+		std::cout << tp->getName() << ":";
+		for (size_t hi = 0; hi < std::size(heuristics); hi++)
+		{
+			CountingOptions options;
+			options.branchHeuristic = heuristics[hi];
+			const auto start = std::chrono::steady_clock::now();
+			InstanceCounter counter(*tp, options);
+			const size_t count = counter.count();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			totals[hi] += seconds;
+			std::cout << " " << getBranchHeuristicName(heuristics[hi]) << "=" << count << "/" << counter.getDecisionCount() << "/" << seconds * 1000 << "ms";
+		}
+		std::cout << std::endl;
+	}
+	std::cout << "total:";
+	for (size_t hi = 0; hi < std::size(heuristics); hi++)
+		std::cout << " " << getBranchHeuristicName(heuristics[hi]) << "=" << totals[hi] * 1000 << "ms";
+	std::cout << std::endl;
+}
+
+// prints how much the simplification removed from the flat relations of every type
+void printSimplification(const Universe& universe)
+{
+	SimplificationStats total;
+	const auto& print = [](const SimplificationStats& stats)
+	{
+		std::cout << " clauses " << stats.clausesBefore << " -> " << stats.clausesAfter
+			<< ", literals " << stats.literalsBefore << " -> " << stats.literalsAfter
+			<< ", subsumed " << stats.subsumedClauses << ", strengthened " << stats.strengthenedClauses
+			<< ", failed literals " << stats.failedLiterals << ", substituted " << stats.substitutedVariables
+			<< ", eliminated " << stats.eliminatedVariables << std::endl;
+	};
+	for (const auto& tp : universe.getTypes())
+	{
+		std::cout << tp->getName() << ":";
+		print(tp->getSimplificationStats());
+		total += tp->getSimplificationStats();
+	}
+	std::cout << "total:";
+	print(total);
+}
+
+// prints the estimated count of every type next to its exact count
+void printApproximation(const Universe& universe, const ApproximationOptions& options)
+{
+	for (const auto& tp : universe.getTypes())
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const double estimate = ApproximateCounter(*tp, options).count();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << tp->getName() << ": " << estimate << " (" << seconds * 1000 << "ms) exact " << tp->getPossibleInstancesCount() << std::endl;
+	}
+}
+
+// prints the implications between the (own) properties of every type and the rate at which the oracle answers them
+void printImplications(const Universe& universe)
+{
+	size_t queries = 0;
+	double seconds = 0;
+	for (const auto& tp : universe.getTypes())
+	{
+		const auto start = std::chrono::steady_clock::now();
+		ConsistencyOracle oracle(*tp);
+		std::cout << tp->getName() << ":";
+		PartialAssignment premises(tp->getDeepPropertyDistinctCount());
+		for (PropertyHandle p0 = 1; p0 <= tp->getPropertyCount(); p0++)
+		{
+			const uint32_t index0 = tp->getDeepPropertyIndex(DeepPropertyHandle(p0));
+			premises.set(index0, true);
+			for (PropertyHandle p1 = 1; p1 <= tp->getPropertyCount(); p1++)
+			{
+				const uint32_t index1 = tp->getDeepPropertyIndex(DeepPropertyHandle(p1));
+				if (index1 != index0 && oracle.implies(premises, index1, true))
+					std::cout << " " << tp->getPropertyName(p0) << "=>" << tp->getPropertyName(p1);
+			}
+			premises.unset(index0);
+		}
+		std::cout << std::endl;
+		queries += oracle.getQueryCount();
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::cout << queries << " queries in " << seconds * 1000 << "ms" << std::endl;
+}
+
+// prints the cubes of the top-level property combinations of the type that no example covers
+void printCoverage(const StructType& type)
+{
+	CoverageAnalyzer analyzer(type);
+	size_t combinations = 0;
+	for (const CoverageCube& cube : analyzer.findUncovered())
+	{
+		for (const uint32_t variable : analyzer.getTopLevelProperties())
+		{
+			if (cube.cube.isSpecified(variable))
+				std::cout << (cube.cube.getValue(variable) ? "" : "~") << type.getDeepPropertyName(variable) << " ";
+		}
+		std::cout << ": " << cube.combinationCount << " combinations, " << cube.instanceCount << " instances" << std::endl;
+		combinations += cube.combinationCount;
+	}
+	std::cout << combinations << " uncovered combinations of " << analyzer.getTopLevelProperties().size() << " properties, "
+		<< analyzer.getExampleCubes().size() << " examples" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	// with --threads, the instances are counted by a parallel search instead of the compiled circuits,
+	// with --benchmark, the branch heuristics are compared instead of printing the report,
+	// --simplification prints what the simplification removed and --eliminate enables the elimination of the defined properties,
+	// --approximate <tolerance> <confidence> compares the estimated counts with the exact ones
+	// --enumerate <type> <path> writes the instances of the type to the file, as cubes with --cubes,
+	// --count <type> <expression> counts the instances of the type that satisfy the property expression
+	// --implications prints the implications between the properties of every type
+	// --matrix <type> prints the implication matrix of the type over the literals of its deep properties
+	// --coverage <type> prints the combinations of the top-level properties of the type without an example
+	// --reload <path> reloads the universe with the types from the file instead, printing the types it parsed again,
+	// --save-snapshot <path> writes the preprocessed universe to the file
+	// and --snapshot <path> loads the universe from the file instead of parsing and preprocessing the sources
+	uint32_t threadCount = 0;
+	bool benchmark = false;
+	bool simplification = false;
+	bool implications = false;
+	const char* matrixType = nullptr;
+	const char* coverageType = nullptr;
+	const char* reloadPath = nullptr;
+	const char* savedSnapshotPath = nullptr;
+	const char* snapshotPath = nullptr;
+	bool approximate = false;
+	ApproximationOptions approximationOptions;
+	const char* enumeratedType = nullptr;
+	const char* enumerationPath = nullptr;
+	EnumerationOptions enumerationOptions;
+	const char* countedType = nullptr;
+	const char* countedExpression = nullptr;
+	SimplificationOptions simplificationOptions;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+			threadCount = std::stoul(argv[++i]);
+		else if (!std::strcmp(argv[i], "--benchmark"))
+			benchmark = true;
+		else if (!std::strcmp(argv[i], "--simplification"))
+			simplification = true;
+		else if (!std::strcmp(argv[i], "--implications"))
+			implications = true;
+		else if (!std::strcmp(argv[i], "--matrix") && i + 1 < argc)
+			matrixType = argv[++i];
+		else if (!std::strcmp(argv[i], "--coverage") && i + 1 < argc)
+			coverageType = argv[++i];
+		else if (!std::strcmp(argv[i], "--reload") && i + 1 < argc)
+			reloadPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--save-snapshot") && i + 1 < argc)
+			savedSnapshotPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--snapshot") && i + 1 < argc)
+			snapshotPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--eliminate"))
+			simplificationOptions.eliminateDefined = true;
+		else if (!std::strcmp(argv[i], "--approximate") && i + 2 < argc)
+		{
+			approximate = true;
+			approximationOptions.tolerance = std::stod(argv[++i]);
+			approximationOptions.confidence = std::stod(argv[++i]);
+		}
+		else if (!std::strcmp(argv[i], "--enumerate") && i + 2 < argc)
+		{
+			enumeratedType = argv[++i];
+			enumerationPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--cubes"))
+			enumerationOptions.cubes = true;
+		else if (!std::strcmp(argv[i], "--count") && i + 2 < argc)
+		{
+			countedType = argv[++i];
+			countedExpression = argv[++i];
+		}
+	}
+
 	Universe universe;
-	std::ifstream typesSrc("../../data/types");
 	ErrorReporter er(std::cout);
-	parse(universe, typesSrc, er);
-	universe.preprocess();
+	IncrementalParser parser;
+	const MappedFile typesFile("../../data/types");
+	const MappedFile examplesFile("../../data/examples");
+	vec<std::string_view> sources;
+	if (snapshotPath)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		if (!universe.loadSnapshot(snapshotPath))
+		{
+			std::cout << "cannot load the snapshot " << snapshotPath << std::endl;
+			return 1;
+		}
+		std::cout << "loaded " << universe.getTypes().size() << " types in "
+			<< std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+	}
+	else
+	{
+		sources = { typesFile.getView(), examplesFile.getView() };
+		parser.parse(universe, sources, er);
+		universe.precheck(er);
+		if (er.getReported())
+			return 1;
+		universe.preprocess(simplificationOptions, threadCount);
+	}
+	universe.checkExamples(er);
+	if (savedSnapshotPath && !universe.saveSnapshot(savedSnapshotPath))
+	{
+		std::cout << "cannot write the snapshot " << savedSnapshotPath << std::endl;
+		return 1;
+	}
+	if (reloadPath && !snapshotPath)
+	{
+		const MappedFile reloadFile(reloadPath);
+		sources[0] = reloadFile.getView();
+		const auto start = std::chrono::steady_clock::now();
+		const vec<StructType*> reparsed = parser.reparse(universe, sources, er);
+		universe.precheck(er);
+		if (er.getReported())
+			return 1;
+		universe.preprocess(simplificationOptions, threadCount);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "reloaded " << reparsed.size() << " of " << universe.getTypes().size() << " types in " << seconds << " s:";
+		for (const StructType* type : reparsed)
+			std::cout << " " << type->getName();
+		std::cout << std::endl;
+		universe.checkExamples(er);
+	}
+	if (simplification)
+	{
+		printSimplification(universe);
+		return 0;
+	}
+	if (coverageType)
+	{
+		const StructType* type = universe.getType(coverageType);
+		if (!type)
+		{
+			std::cout << "unknown type " << coverageType << std::endl;
+			return 1;
+		}
+		printCoverage(*type);
+		return 0;
+	}
+	if (matrixType)
+	{
+		StructType* type = universe.getType(matrixType);
+		if (!type)
+		{
+			std::cout << "unknown type " << matrixType << std::endl;
+			return 1;
+		}
+		type->buildImplicationIndex();
+		type->getImplicationIndex()->printMatrix(std::cout);
+		return 0;
+	}
+	if (implications)
+	{
+		printImplications(universe);
+		return 0;
+	}
+	if (countedType)
+	{
+		const StructType* type = universe.getType(countedType);
+		if (!type)
+		{
+			std::cout << "unknown type " << countedType << std::endl;
+			return 1;
+		}
+		std::istringstream expression(countedExpression);
+		ErrorReporter expressionEr(std::cout);
+		const PropertyRelations assumptions = parseAssumptions(*type, expression, expressionEr);
+		if (expressionEr.getReported())
+			return 1;
+		std::cout << type->getPossibleInstancesCount(assumptions) << " of " << type->getPossibleInstancesCount() << std::endl;
+		return 0;
+	}
+	if (enumeratedType)
+	{
+		const StructType* type = universe.getType(enumeratedType);
+		if (!type)
+		{
+			std::cout << "unknown type " << enumeratedType << std::endl;
+			return 1;
+		}
+		InstanceEnumerator enumerator(*type, enumerationOptions);
+		std::ofstream output(enumerationPath, std::ios::binary);
+		std::cout << writeInstances(enumerator, output) << (enumerationOptions.cubes ? " cubes" : " instances") << " written" << std::endl;
+		return 0;
+	}
+	if (approximate)
+	{
+		printApproximation(universe, approximationOptions);
+		return 0;
+	}
+	if (benchmark)
+	{
+		benchmarkHeuristics(universe);
+		return 0;
+	}
+	if (!threadCount)
+		universe.compile();
 	//std::cout << universe.getType("set")->getPossibleInstancesCount() << endl;
 	for (const auto& tp : universe.getTypes())
 	{
 		std::cout << tp->getName() << ": " << tp->getDeepPropertyDistinctCount() << "/" << tp->getDeepPropertyFullCount()
 			<< " " << tp->getDeepMemberDistinctCount() << "/" << tp->getDeepMemberFullCount()
 			<< " " << tp->getFlatRelationCount()
-			<< " " << tp->getPossibleInstancesCount()
+			<< " " << (threadCount ? ParallelCounter(*tp, threadCount).count() : tp->getPossibleInstancesCount())
 			<< std::endl;
 	}
 }
\ No newline at end of file
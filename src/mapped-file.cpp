@@ -0,0 +1,57 @@
+#include "mapped-file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const str& path)
+{
+	const int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return;
+	struct stat status;
+	if (fstat(descriptor, &status) == 0)
+	{
+		size = status.st_size;
+		if (size == 0)
+			open = true;
+		else
+		{
+			void* const mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+			if (mapped != MAP_FAILED)
+			{
+				data = static_cast<const char*>(mapped);
+				open = true;
+			}
+		}
+	}
+	// the mapping stays valid after the descriptor is closed
+	close(descriptor);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+		munmap(const_cast<char*>(data), size);
+}
+
+bool MappedFile::isOpen() const
+{
+	return open;
+}
+
+const char* MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
+
+std::string_view MappedFile::getView() const
+{
+	return std::string_view(data, size);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "str.hpp"
+
+// A file mapped read-only into memory, so that the processes mapping the same file share its pages.
+class MappedFile
+{
+public:
+	MappedFile(const str& path);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const;
+	const char* getData() const;
+	size_t getSize() const;
+	// the whole file, empty if it could not be mapped
+	std::string_view getView() const;
+
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+	bool open = false;
+};
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "parallel-counter.hpp"
+
+#include <cassert>
+
+ParallelCounter::ParallelCounter(const StructType& type, const uint32_t threadCount, const CountingOptions& options)
+	: type(&type), options(options), pool(threadCount), workerCounters(threadCount)
+{
+	assert(type.isPreprocessed());
+	// a few more tasks than workers per level of imbalance
+	splitDepth = 3;
+	for (uint32_t threads = 1; threads < threadCount; threads *= 2)
+		splitDepth++;
+}
+
+size_t ParallelCounter::count()
+{
+	return count(PartialAssignment(type->getDeepPropertyDistinctCount()));
+}
+
+size_t ParallelCounter::count(const PartialAssignment& assumptions)
+{
+	total = 0;
+	submitCount(*type, assumptions, 0);
+	pool.wait();
+	return total;
+}
+
+uint32_t ParallelCounter::getThreadCount() const
+{
+	return pool.getThreadCount();
+}
+
+void ParallelCounter::setSplitDepth(const uint32_t depth)
+{
+	splitDepth = depth;
+}
+
+void ParallelCounter::submitCount(const StructType& countedType, const PartialAssignment& assumptions, const uint32_t depth)
+{
+	pool.submit([this, &countedType, taskAssumptions = PartialAssignment(assumptions), depth]() mutable
+	{
+		countTask(countedType, taskAssumptions, depth);
+	});
+}
+
+void ParallelCounter::countTask(const StructType& countedType, PartialAssignment& assumptions, const uint32_t depth)
+{
+	if (depth >= splitDepth)
+	{
+		total += getWorkerCounter(countedType).count(assumptions);
+		return;
+	}
+	// the instances with an undecided promoted property are counted by the type it promotes to,
+	// exactly as the sequential counter does before it branches
+	for (const Promotion& promotion : countedType.getPromotions())
+	{
+		if (assumptions.isSpecified(promotion.property))
+			continue;
+		PartialAssignment projected;
+		if (promotion.project(assumptions, projected))
+			submitCount(*promotion.target, projected, depth + 1);
+		assumptions.set(promotion.property, false);
+	}
+	uint32_t branch = 0;
+	while (branch < assumptions.getVariableCount() && assumptions.isSpecified(branch))
+		branch++;
+	if (branch == assumptions.getVariableCount())
+	{
+		total += getWorkerCounter(countedType).count(assumptions);
+		return;
+	}
+	assumptions.set(branch, true);
+	submitCount(countedType, assumptions, depth + 1);
+	assumptions.set(branch, false);
+	countTask(countedType, assumptions, depth + 1);
+}
+
+InstanceCounter& ParallelCounter::getWorkerCounter(const StructType& countedType)
+{
+	const uint32_t worker = pool.getCurrentWorker();
+	assert(worker != ThreadPool::NoWorker);
+	uptr<InstanceCounter>& counter = workerCounters[worker][&countedType];
+	if (!counter)
+	{
+		CountingOptions workerOptions = options;
+		workerOptions.cacheMemoryLimit /= pool.getThreadCount();
+		counter = make_unique<InstanceCounter>(countedType, workerOptions);
+	}
+	return *counter;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "instance-counter.hpp"
+#include "partial-assignment.hpp"
+#include "thread-pool.hpp"
+
+// Counts the instances of a type on a work-stealing thread pool.
+// The promotion branches and the first levels of the property branches become tasks, the remaining subtrees
+// are counted by a sequential InstanceCounter per worker and type, so the result equals the sequential count.
+class ParallelCounter
+{
+public:
+	ParallelCounter(const StructType& type, uint32_t threadCount, const CountingOptions& options = CountingOptions());
+
+	size_t count();
+	size_t count(const PartialAssignment& assumptions);
+
+	uint32_t getThreadCount() const;
+	// the number of property branching levels split into tasks
+	void setSplitDepth(uint32_t depth);
+
+private:
+	const StructType* type;
+	CountingOptions options;
+	uint32_t splitDepth;
+	ThreadPool pool;
+
+	// the counters of every worker, by type; the caches survive across tasks and queries
+	vec<umap<const StructType*, uptr<InstanceCounter>>> workerCounters;
+	std::atomic<size_t> total{0};
+
+	void submitCount(const StructType& type, const PartialAssignment& assumptions, uint32_t depth);
+	void countTask(const StructType& type, PartialAssignment& assumptions, uint32_t depth);
+	InstanceCounter& getWorkerCounter(const StructType& type);
+};
\ No newline at end of file
@@ -4,10 +4,12 @@
 
 #include "print.hpp"
 #include "str.hpp"
+#include "symbol-table.hpp"
+#include "vec.hpp"
 
 using std::ostream;
 
-enum class LexTokenType
+enum class LexTokenType : uint8_t
 {
 	LAngleBra,
 	RAngleBra,
@@ -40,24 +42,134 @@ enum class LexTokenType
 struct LexToken
 {
 	LexTokenType type;
-	str content;
 	uint32_t lineNumber;
+	// the range of the token in the source, a literal includes its quotes
+	uint32_t offset;
+	uint32_t length;
+	// the interned name of an identifier or the content of a literal, NoSymbol for the other tokens
+	Symbol symbol;
+	// the text of the symbol, owned by the symbol table
+	const str* content;
+
+	LexToken(const LexTokenType type, const uint32_t lineNumber, const uint32_t offset, const uint32_t length, const Symbol symbol, const str* content)
+		: type(type), lineNumber(lineNumber), offset(offset), length(length), symbol(symbol), content(content)
+	{
+	}
+};
+
+// The tokens of a source stored as separate arrays, so that the scans over the token types touch only the types.
+// The tokens are read by value, with the text of their symbols resolved by the symbol table.
+class TokenBuffer
+{
+public:
+	TokenBuffer(const SymbolTable& symbols) : symbols(&symbols)
+	{
+	}
+
+	void push(const LexTokenType type, const uint32_t lineNumber, const uint32_t offset, const uint32_t length, const Symbol symbol = SymbolTable::NoSymbol)
+	{
+		types.push_back(type);
+		lineNumbers.push_back(lineNumber);
+		offsets.push_back(offset);
+		lengths.push_back(length);
+		tokenSymbols.push_back(symbol);
+	}
+
+	size_t size() const
+	{
+		return types.size();
+	}
+
+	LexTokenType getType(const size_t i) const
+	{
+		return types[i];
+	}
+
+	uint32_t getLineNumber(const size_t i) const
+	{
+		return lineNumbers[i];
+	}
+
+	LexToken operator[](const size_t i) const
+	{
+		return LexToken(types[i], lineNumbers[i], offsets[i], lengths[i], tokenSymbols[i], &symbols->getName(tokenSymbols[i]));
+	}
+
+private:
+	const SymbolTable* symbols;
+	vec<LexTokenType> types;
+	vec<uint32_t> lineNumbers;
+	vec<uint32_t> offsets;
+	vec<uint32_t> lengths;
+	vec<Symbol> tokenSymbols;
+};
 
-	LexToken(const LexTokenType type, const uint32_t lineNumber) : type(type), lineNumber(lineNumber)
-	{}
+// The tokens start .. end - 1 of a buffer, e.g. the ones of a statement, which the blocks refer to instead of copying them.
+class TokenRange
+{
+public:
+	TokenRange() = default;
+	TokenRange(const TokenBuffer& buffer, const uint32_t start, const uint32_t end) : buffer(&buffer), start(start), end(end)
+	{
+	}
+
+	size_t size() const
+	{
+		return end - start;
+	}
+
+	bool empty() const
+	{
+		return start == end;
+	}
+
+	LexToken operator[](const size_t i) const
+	{
+		return (*buffer)[start + i];
+	}
 
-	LexToken(const LexTokenType type, const str& content, const uint32_t lineNumber) : type(type), content(content), lineNumber(lineNumber)
+	LexToken front() const
 	{
+		return (*buffer)[start];
 	}
+
+	LexToken back() const
+	{
+		return (*buffer)[end - 1];
+	}
+
+	bool contains(const LexTokenType type) const
+	{
+		for (uint32_t i = start; i < end; i++)
+		{
+			if (buffer->getType(i) == type)
+				return true;
+		}
+		return false;
+	}
+
+private:
+	const TokenBuffer* buffer = nullptr;
+	uint32_t start = 0;
+	uint32_t end = 0;
 };
 
 struct Identifier
 {
-	str name;
+	Symbol symbol;
 	uint32_t lineNumber;
 
 	Identifier() = default;
-	Identifier(const LexToken& token) : name(token.content), lineNumber(token.lineNumber) {}
+	Identifier(const LexToken& token) : symbol(token.symbol), lineNumber(token.lineNumber), name(token.content) {}
+
+	const str& getName() const
+	{
+		return *name;
+	}
+
+private:
+	// the interned name, owned by the symbol table
+	const str* name = nullptr;
 };
 
 class ErrorReporter
@@ -8,163 +8,203 @@
 #include "parse-utils.hpp"
 #include "vec.hpp"
 
-// Performs lexical analysis. I.e. converts a stream of raw characters into a stream of tokens
-void tokenize(vec<LexToken>& tokens, istream& defs, ErrorReporter& er)
+enum class CharClass : uint8_t
 {
-	vec<char> chars;
-	const str input(std::istreambuf_iterator<char>(defs), {});
+	Illegal,
+	Space,
+	Newline,
+	Identifier,
+	Operator,
+	Quote
+};
+
+struct CharTables
+{
+	CharClass classes[256];
+	// the token of a single-char operator
+	LexTokenType operators[256];
+};
+
+static constexpr CharTables makeCharTables()
+{
+	CharTables tables{};
+	for (int c = 0; c < 256; c++)
+	{
+		tables.classes[c] = CharClass::Illegal;
+		tables.operators[c] = LexTokenType::Identifier;
+	}
+	tables.classes[int(' ')] = tables.classes[int('\t')] = tables.classes[int('\r')] = CharClass::Space;
+	tables.classes[int('\n')] = CharClass::Newline;
+	for (int c = 'a'; c <= 'z'; c++)
+		tables.classes[c] = CharClass::Identifier;
+	for (int c = 'A'; c <= 'Z'; c++)
+		tables.classes[c] = CharClass::Identifier;
+	for (int c = '0'; c <= '9'; c++)
+		tables.classes[c] = CharClass::Identifier;
+	tables.classes[int('-')] = tables.classes[int('_')] = tables.classes[int('^')] = CharClass::Identifier;
+	tables.classes[int('"')] = CharClass::Quote;
+	const char operatorChars[] = "<>=()~{}/!*|&.,;";
+	const LexTokenType operatorTypes[] = { LexTokenType::LAngleBra, LexTokenType::RAngleBra, LexTokenType::Equals, LexTokenType::LPar,
+		LexTokenType::RPar, LexTokenType::Negate, LexTokenType::LCurlyBra, LexTokenType::RCurlyBra, LexTokenType::Property,
+		LexTokenType::Exclusive, LexTokenType::ExclusiveOr, LexTokenType::Or, LexTokenType::And, LexTokenType::Dot, LexTokenType::Comma, LexTokenType::Semic };
+	for (int oi = 0; oi < int(sizeof(operatorTypes) / sizeof(operatorTypes[0])); oi++)
+	{
+		tables.classes[int(operatorChars[oi])] = CharClass::Operator;
+		tables.operators[int(operatorChars[oi])] = operatorTypes[oi];
+	}
+	return tables;
+}
+
+static constexpr CharTables charTables = makeCharTables();
 
-	uint64_t lineNumber = 1;
-	
-	bool insideLiteral = false;
-	vec<char> literalContent;
-	const auto submitLiteral = [&]
+static LexTokenType getKeywordType(const char* identifier, const size_t length)
+{
+	const auto& is = [identifier, length](const char* keyword, const size_t keywordLength)
 	{
-		literalContent.push_back('\0');
-		tokens.push_back(LexToken(LexTokenType::Literal, str(&literalContent.front()), lineNumber));
-		insideLiteral = false;
-		literalContent.clear();
+		return length == keywordLength && std::equal(identifier, identifier + length, keyword);
 	};
+	if (is("example", 7))
+		return LexTokenType::KWExample;
+	if (is("type", 4))
+		return LexTokenType::KWType;
+	if (is("property", 8))
+		return LexTokenType::KWProperty;
+	if (is("_name", 5))
+		return LexTokenType::KWName;
+	if (is("_description", 12))
+		return LexTokenType::KWDescription;
+	return LexTokenType::Identifier;
+}
 
-	int64_t identifierStart = -1;
-	const auto endIdentifier = [&](const int64_t i)
+// Performs lexical analysis. I.e. converts a range of raw characters into a stream of tokens.
+// The characters are classified by a table, so every run of identifier characters or spaces is scanned by a tight loop,
+// and the tokens refer back to their ranges in the source. The identifiers and the literals are interned into the symbol table.
+void tokenize(TokenBuffer& tokens, const char* const source, const size_t size, SymbolTable& symbols, ErrorReporter& er)
+{
+	const unsigned char* const input = reinterpret_cast<const unsigned char*>(source);
+	const auto& classOf = [input](const size_t i)
 	{
-		if (identifierStart != -1)
-		{
-			const str id = input.substr(identifierStart, i - identifierStart);
-			LexTokenType tokenType = LexTokenType::Identifier;
-			if (id == "example")
-				tokenType = LexTokenType::KWExample;
-			else if (id == "type")
-				tokenType = LexTokenType::KWType;
-			else if (id == "property")
-				tokenType = LexTokenType::KWProperty;
-			else if (id == "_name")
-				tokenType = LexTokenType::KWName;
-			else if (id == "_description")
-				tokenType = LexTokenType::KWDescription;
-			tokens.push_back(tokenType == LexTokenType::Identifier ? LexToken(tokenType, id, lineNumber) : LexToken(tokenType, lineNumber));
-			identifierStart = -1;
-		}
+		return charTables.classes[input[i]];
+	};
+	const auto& isPromotesTo = [input, size](const size_t i)
+	{
+		return input[i] == '-' && i + 1 < size && input[i + 1] == '>';
 	};
 
-	uint64_t nwlScan = 0;
-	for (uint64_t i = 0; i < input.length(); i++)
+	uint32_t lineNumber = 1;
+	size_t i = 0;
+	// the content of a literal, reused so that only the longest literal allocates
+	str content;
+	while (i < size)
 	{
-		while (nwlScan < i)
+		switch (classOf(i))
 		{
-			if (input[nwlScan] == '\n')
-				lineNumber++;
-			nwlScan++;
+		case CharClass::Space:
+			while (++i < size && classOf(i) == CharClass::Space)
+				;
+			break;
+		case CharClass::Newline:
+			lineNumber++;
+			i++;
+			break;
+		case CharClass::Identifier:
+		{
+			if (isPromotesTo(i))
+			{
+				tokens.push(LexTokenType::PromotesTo, lineNumber, i, 2);
+				i += 2;
+				break;
+			}
+			const size_t start = i;
+			while (++i < size && classOf(i) == CharClass::Identifier && !isPromotesTo(i))
+				;
+			const LexTokenType tokenType = getKeywordType(source + start, i - start);
+			const Symbol symbol = tokenType == LexTokenType::Identifier ? symbols.intern(std::string_view(source + start, i - start)) : SymbolTable::NoSymbol;
+			tokens.push(tokenType, lineNumber, start, i - start, symbol);
+			break;
 		}
-
-		if (insideLiteral)
+		case CharClass::Operator:
+		{
+			LexTokenType tokenType = charTables.operators[input[i]];
+			uint32_t length = 1;
+			if (input[i] == '=' && i + 1 < size && (input[i + 1] == '>' || input[i + 1] == '='))
+			{
+				tokenType = input[i + 1] == '>' ? LexTokenType::Implies : LexTokenType::Equivalent;
+				length = 2;
+			}
+			tokens.push(tokenType, lineNumber, i, length);
+			i += length;
+			break;
+		}
+		case CharClass::Quote:
 		{
-			if (input[i] == '\\')
+			// the content is appended in runs between the escapes, the token gets the line of its closing quote
+			const size_t start = i++;
+			content.clear();
+			bool closed = false;
+			while (i < size && !closed)
 			{
-				if (i + 1 == input.length())
+				const size_t runStart = i;
+				while (i < size && input[i] != '"' && input[i] != '\\')
+				{
+					if (input[i] == '\n')
+						lineNumber++;
+					i++;
+				}
+				content.append(source + runStart, i - runStart);
+				if (i == size)
+					break;
+				if (input[i] == '"')
+				{
+					closed = true;
+					i++;
+				}
+				else if (i + 1 == size)
 				{
 					er.reportLex(lineNumber, "EOF after an escape slash.");
-					continue;
+					i++;
 				}
-				if (input[i + 1] == '\\')
-					literalContent.push_back('\\');
-				else if (input[i + 1] == '\"')
-					literalContent.push_back('\"');
 				else
-					er.reportLex(lineNumber, "Illegal char after an escape slash.");
-				i++;
-			}
-			else if (input[i] == '\"')
-			{
-				submitLiteral();
-			}
-			else
-			{
-				literalContent.push_back(input[i]);
+				{
+					if (input[i + 1] == '\\' || input[i + 1] == '"')
+						content.push_back(input[i + 1]);
+					else
+						er.reportLex(lineNumber, "Illegal char after an escape slash.");
+					if (input[i + 1] == '\n')
+						lineNumber++;
+					i += 2;
+				}
 			}
-			continue;
-		}
-		if (input[i] == '\"')
-		{
-			endIdentifier(i);
-			insideLiteral = true;
-			continue;
-		}
-		const auto checkFor2CharOperator = [&](const char c0, const char c1, const LexTokenType tokenType)
-		{
-			if (i + 1 != input.length() && input[i] == c0 && input[i + 1] == c1)
+			if (closed)
 			{
-				endIdentifier(i);
-				tokens.push_back(LexToken(tokenType, lineNumber));
-				i++;
-				return true;
+				tokens.push(LexTokenType::Literal, lineNumber, start, i - start, symbols.intern(content));
+				break;
 			}
-			return false;
-		};
-		if (checkFor2CharOperator('=', '>', LexTokenType::Implies))
-			continue;
-		if (checkFor2CharOperator('-', '>', LexTokenType::PromotesTo))
-			continue;
-		if (checkFor2CharOperator('=', '=', LexTokenType::Equivalent))
-			continue;
-		const umap<char, LexTokenType> operators{
-			{'<', LexTokenType::LAngleBra},
-			{'>', LexTokenType::RAngleBra},
-			{'=', LexTokenType::Equals},
-			{'(', LexTokenType::LPar},
-			{')', LexTokenType::RPar},
-			{'~', LexTokenType::Negate},
-			{'{', LexTokenType::LCurlyBra},
-			{'}', LexTokenType::RCurlyBra},
-			{'/', LexTokenType::Property},
-			{'!', LexTokenType::Exclusive},
-			{'*', LexTokenType::ExclusiveOr},
-			{'|', LexTokenType::Or},
-			{'&', LexTokenType::And},
-			{'.', LexTokenType::Dot},
-			{',', LexTokenType::Comma},
-			{';', LexTokenType::Semic}
-		};
-
-		if (operators.find(input[i]) != operators.end())
-		{
-			endIdentifier(i);
-			tokens.push_back(LexToken(operators.at(input[i]), lineNumber));
-			continue;
+			// the line of the last char, a final newline does not start another one
+			const uint32_t lastLine = input[size - 1] == '\n' ? lineNumber - 1 : lineNumber;
+			tokens.push(LexTokenType::Literal, lastLine, start, size - start, symbols.intern(content));
+			er.reportLex(lastLine, "EOF inside a string literal.");
+			break;
 		}
-
-		if (input[i] == ' ' || input[i] == '\t' || input[i] == '\n' || input[i] == '\r')
-		{
-			endIdentifier(i);
-			continue;
+		default:
+			er.reportLex(lineNumber, "Illegal char.");
+			i++;
+			break;
 		}
-
-		if ((input[i] >= 'a' && input[i] <= 'z') || (input[i] >= 'A' && input[i] <= 'Z') || (input[i] >= '0' && input[i] <= '9') || input[i] == '-' || input[i] == '_' || input[i] == '^')
-		{
-			if (identifierStart == -1)
-				identifierStart = i;
-			continue;
-		}
-
-		endIdentifier(i);
-		er.reportLex(lineNumber, "Illegal char.");
-	}
-	if (insideLiteral)
-	{
-		submitLiteral();
-		er.reportLex(lineNumber, "EOF inside a string literal.");
-	}
-	else
-	{
-		endIdentifier(input.length());
 	}
 }
 
+void tokenize(TokenBuffer& tokens, istream& defs, SymbolTable& symbols, ErrorReporter& er)
+{
+	const str input(std::istreambuf_iterator<char>(defs), {});
+	tokenize(tokens, input.data(), input.size(), symbols, er);
+}
+
+// A statement or a scope with its description, referring to its tokens in the buffer of the source.
 class SynBlock
 {
 public:
-	SynBlock(const vec<LexToken>& tokens, const bool isScope, const uint32_t lineNumber)
+	SynBlock(const TokenRange& tokens, const bool isScope, const uint32_t lineNumber)
 		: tokens(tokens),
 		isScope(isScope),
 		lineNumber(lineNumber)
@@ -176,7 +216,7 @@ public:
 		contents.push_back(std::move(newContent));
 	}
 
-	const vec<LexToken>& getTokens() const
+	const TokenRange& getTokens() const
 	{
 		return tokens;
 	}
@@ -197,15 +237,15 @@ public:
 	}
 
 private:
-	vec<LexToken> tokens;
+	TokenRange tokens;
 	bool isScope;
 	uint32_t lineNumber;
 	vec<uptr<SynBlock>> contents;
 };
 
-void blockAnalysis(SynBlock& parent, const vec<LexToken>& tokens, ErrorReporter& er)
+void blockAnalysis(SynBlock& parent, const TokenBuffer& tokens, ErrorReporter& er)
 {
-	if (tokens.empty())
+	if (tokens.size() == 0)
 		return;
 	uint32_t nxt = 0;
 	uint32_t currentStart = 0;
@@ -213,33 +253,32 @@ void blockAnalysis(SynBlock& parent, const vec<LexToken>& tokens, ErrorReporter&
 	scopes.push(&parent);
 	const auto addTokens = [&](const bool isScope)
 	{
-		vec<LexToken> commandTokens;
-		commandTokens.insert(commandTokens.end(), tokens.begin() + currentStart, tokens.begin() + nxt);
-		scopes.top()->addContent(make_unique<SynBlock>(commandTokens, isScope, tokens[currentStart].lineNumber));
+		scopes.top()->addContent(make_unique<SynBlock>(TokenRange(tokens, currentStart, nxt), isScope, tokens.getLineNumber(currentStart)));
 	};
 	while (nxt < tokens.size())
 	{
-		if (tokens[nxt].type == LexTokenType::Semic)
+		const LexTokenType type = tokens.getType(nxt);
+		if (type == LexTokenType::Semic)
 		{
 			addTokens(false);
 			currentStart = nxt + 1;
 		}
-		else if (tokens[nxt].type == LexTokenType::LCurlyBra)
+		else if (type == LexTokenType::LCurlyBra)
 		{
 			addTokens(true);
 			scopes.push(scopes.top()->getContents().back().get());
 			currentStart = nxt + 1;
 		}
-		else if (tokens[nxt].type == LexTokenType::RCurlyBra)
+		else if (type == LexTokenType::RCurlyBra)
 		{
 			if (currentStart != nxt)
 			{
 				addTokens(false);
-				er.reportSyn(tokens[nxt].lineNumber, "Missing semicolon.");
+				er.reportSyn(tokens.getLineNumber(nxt), "Missing semicolon.");
 			}
 			currentStart = nxt + 1;
 			if (scopes.size() == 1)
-				er.reportSyn(tokens[nxt].lineNumber, "Unmatched closing bracket.");
+				er.reportSyn(tokens.getLineNumber(nxt), "Unmatched closing bracket.");
 			else
 				scopes.pop();
 		}
@@ -248,26 +287,26 @@ void blockAnalysis(SynBlock& parent, const vec<LexToken>& tokens, ErrorReporter&
 	if (currentStart != tokens.size())
 	{
 		addTokens(false);
-		er.reportSyn(tokens.back().lineNumber, "Missing semicolon.");
+		er.reportSyn(tokens.getLineNumber(tokens.size() - 1), "Missing semicolon.");
 	}
 	if (scopes.size() > 1)
-		er.reportSyn(tokens.back().lineNumber, scopes.size() == 2 ? "Unclosed bracket." : "Unclosed bracket.");
+		er.reportSyn(tokens.getLineNumber(tokens.size() - 1), scopes.size() == 2 ? "Unclosed bracket." : "Unclosed bracket.");
 }
 
 void processTypeDeclaration(Universe& universe, const vec<Identifier>& declarators, ErrorReporter& er)
 {
 	for (const Identifier& typeDecl : declarators)
 	{
-		if (universe.getType(typeDecl.name))
+		if (universe.getType(typeDecl.symbol))
 		{
-			er.reportSem(typeDecl, "The type " + typeDecl.name + " has already been declared before.");
+			er.reportSem(typeDecl, "The type " + typeDecl.getName() + " has already been declared before.");
 			continue;
 		}
-		universe.addType(typeDecl.name);
+		universe.addType(typeDecl.symbol);
 	}
 }
 
-void parseNonScopeStatement(Universe& universe, const vec<LexToken>& tokens, ErrorReporter& er)
+void parseNonScopeStatement(Universe& universe, const TokenRange& tokens, ErrorReporter& er)
 {
 	if (tokens.empty())
 		return;
@@ -303,10 +342,10 @@ DeepMemberHandle getDeepMemberHandle(const StructType& type, const vec<Identifie
 	const StructType* nextType = &type;
 	for (const Identifier& interMemberId : identifiers)
 	{
-		const MemberHandle handle = nextType->getMember(interMemberId.name);
+		const MemberHandle handle = nextType->getMember(interMemberId.symbol);
 		if (!handle)
 		{
-			er.reportSem(interMemberId, interMemberId.name + " is not a member of the type " + nextType->getName() + ".");
+			er.reportSem(interMemberId, interMemberId.getName() + " is not a member of the type " + nextType->getName() + ".");
 			return {};
 		}
 		handles.push_back(handle);
@@ -323,19 +362,19 @@ DeepPropertyHandle getDeepPropertyHandle(const StructType& type, const vec<Ident
 	const StructType* nextType = &type;
 	for (uint32_t i = 0; i + 1 < identifiers.size(); i++)
 	{
-		const MemberHandle mHandle = nextType->getMember(identifiers[i].name);
+		const MemberHandle mHandle = nextType->getMember(identifiers[i].symbol);
 		if (!mHandle)
 		{
-			er.reportSem(identifiers[i], identifiers[i].name + " is not a member of type " + nextType->getName() + ".");
+			er.reportSem(identifiers[i], identifiers[i].getName() + " is not a member of type " + nextType->getName() + ".");
 			return DeepPropertyHandle(0);
 		}
 		handle.memberPath.push_back(mHandle);
 		nextType = nextType->getMemberType(mHandle);
 	}
-	handle.pHandle = nextType->getProperty(identifiers.back().name);
+	handle.pHandle = nextType->getProperty(identifiers.back().symbol);
 	if (!handle.pHandle)
 	{
-		er.reportSem(identifiers.back(), identifiers.back().name + " is not a property of type " + nextType->getName() + ".");
+		er.reportSem(identifiers.back(), identifiers.back().getName() + " is not a property of type " + nextType->getName() + ".");
 		return DeepPropertyHandle(0);
 	}
 	return handle;
@@ -349,17 +388,17 @@ void getDeepMemberOrPropertyHandle(const StructType& type, const vec<Identifier>
 	for (uint32_t i = 0; i + 1 < identifiers.size(); i++)
 	{
 		const Identifier& interMemberId = identifiers[i];
-		const MemberHandle handle = nextType->getMember(interMemberId.name);
+		const MemberHandle handle = nextType->getMember(interMemberId.symbol);
 		if (!handle)
 		{
-			er.reportSem(interMemberId, interMemberId.name + " is not a member of the type " + nextType->getName() + ".");
+			er.reportSem(interMemberId, interMemberId.getName() + " is not a member of the type " + nextType->getName() + ".");
 			return;
 		}
 		prehandles.push_back(handle);
 		nextType = nextType->getMemberType(handle);
 	}
-	const MemberHandle getMemberHandle = nextType->getMember(identifiers.back().name);
-	const PropertyHandle getPropertyHandle = nextType->getProperty(identifiers.back().name);
+	const MemberHandle getMemberHandle = nextType->getMember(identifiers.back().symbol);
+	const PropertyHandle getPropertyHandle = nextType->getProperty(identifiers.back().symbol);
 	if (getMemberHandle)
 	{
 		prehandles.push_back(getMemberHandle);
@@ -372,15 +411,15 @@ void getDeepMemberOrPropertyHandle(const StructType& type, const vec<Identifier>
 		propertyHandle.pHandle = getPropertyHandle;
 		return;
 	}
-	er.reportSyn(identifiers.back(), identifiers.back().name + " is not a member nor a property of the type " + nextType->getName() + ".");
+	er.reportSyn(identifiers.back(), identifiers.back().getName() + " is not a member nor a property of the type " + nextType->getName() + ".");
 }
 
 bool checkIsNameUsed(const StructType& type, const Identifier& nameId, ErrorReporter& er)
 {
-	if (type.getMember(nameId.name))
-		er.reportSem(nameId, "Type " + type.getName() + " already contains a member named " + nameId.name + ".");
-	else if (type.getProperty(nameId.name))
-		er.reportSem(nameId, "Type " + type.getName() + " already contains a property named " + nameId.name + ".");
+	if (type.getMember(nameId.symbol))
+		er.reportSem(nameId, "Type " + type.getName() + " already contains a member named " + nameId.getName() + ".");
+	else if (type.getProperty(nameId.symbol))
+		er.reportSem(nameId, "Type " + type.getName() + " already contains a property named " + nameId.getName() + ".");
 	else
 		return false;
 	return true;
@@ -402,15 +441,15 @@ struct MemberDeclarator
 
 void processMemberDeclaration(Universe& universe, StructType& type, const Identifier& declaredType, const vec<MemberDeclarator>& declarators, ErrorReporter& er)
 {
-	StructType* const memberType = universe.getType(declaredType.name);
+	StructType* const memberType = universe.getType(declaredType.symbol);
 	if (!memberType)
-		er.reportSem(declaredType, declaredType.name + " doesn't name a type.");
+		er.reportSem(declaredType, declaredType.getName() + " doesn't name a type.");
 	for (const MemberDeclarator& declarator : declarators)
 	{
 		const bool nameUsed = checkIsNameUsed(type, declarator.memberId, er);
 		MemberHandle newHandle = 0;
 		if (!nameUsed && memberType)
-			newHandle = type.addMember(declarator.memberId.name, memberType);
+			newHandle = type.addMember(declarator.memberId.symbol, memberType);
 		if (!declarator.definition.empty())
 		{
 			const vec<MemberHandle> eqHandles = getDeepMemberHandle(type, declarator.definition, er);
@@ -446,7 +485,7 @@ void processPropertyDeclaration(StructType& type, const vec<PropertyDeclarator>&
 	{
 		if (checkIsNameUsed(type, declarator.propertyId, er))
 			continue;
-		const PropertyHandle newHandle = type.addProperty(declarator.propertyId.name);
+		const PropertyHandle newHandle = type.addProperty(declarator.propertyId.symbol);
 		if (!declarator.definition.empty())
 		{
 			const DeepPropertyHandle assignHandle = getDeepPropertyHandle(type, declarator.definition, er);
@@ -464,9 +503,9 @@ void processPromotion(Universe& universe, StructType& scopeType, const vec<Ident
 	const DeepPropertyHandle propertyHandle = getDeepPropertyHandle(scopeType, propertyIdentifiers, er);
 	//if (propertyHandle.empty())
 	//	er.reportSem(propertyIdentifier, propertyIdentifier.name + " doesn't name of property of the type " + scopeType.getName() + ".");
-	const StructType* const promoteTo = universe.getType(typeIdentifier.name);
+	const StructType* const promoteTo = universe.getType(typeIdentifier.symbol);
 	if (!promoteTo)
-		er.reportSem(typeIdentifier, typeIdentifier.name + " doesn't name a type.");
+		er.reportSem(typeIdentifier, typeIdentifier.getName() + " doesn't name a type.");
 	if (propertyHandle.pHandle && promoteTo)
 		scopeType.addPromotion(propertyHandle, promoteTo);
 }
@@ -543,7 +582,8 @@ PropertyRelations relationsNegate(const PropertyRelations& relations)
 		partialRelations.reserve(orBlock.size());
 		for (const DeepProperty& property : orBlock)
 		{
-			const DeepProperty negatedProperty(property.handle, !property.negated);
+			DeepProperty negatedProperty = property;
+			negatedProperty.negated = !negatedProperty.negated;
 			partialRelations.push_back({ negatedProperty });
 		}
 		negatedRelations = relationsOr(negatedRelations, partialRelations);
@@ -594,7 +634,7 @@ PropertyRelations relationsExclusivity(const vec<PropertyRelations>& relations)
 	return newRelations;
 }
 
-PropertyRelations propertyExpressionToRelations(StructType& scopeType, const PropertyExpression& expression, ErrorReporter& er)
+PropertyRelations propertyExpressionToRelations(const StructType& scopeType, const PropertyExpression& expression, ErrorReporter& er)
 {
 	if (expression.operation == PropertyExpressionOperation::None)
 	{
@@ -753,7 +793,7 @@ void processExpressionDeclaration(StructType& scopeType, const PropertyExpressio
 	scopeType.addPropertyRelations(relations);
 }
 
-vec<Identifier> parseDirectMemberChain(const vec<LexToken>& tokens, const uint32_t from, const uint32_t to, ErrorReporter& er)
+vec<Identifier> parseDirectMemberChain(const TokenRange& tokens, const uint32_t from, const uint32_t to, ErrorReporter& er)
 {
 	vec<Identifier> memberIds;
 	if (tokens[from].type != LexTokenType::Identifier)
@@ -783,7 +823,7 @@ vec<Identifier> parseDirectMemberChain(const vec<LexToken>& tokens, const uint32
 	return memberIds;
 }
 
-PropertyExpression parsePropertyExpression(const vec<LexToken>& tokens, const uint32_t from, const uint32_t to, ErrorReporter& er)
+PropertyExpression parsePropertyExpression(const TokenRange& tokens, const uint32_t from, const uint32_t to, ErrorReporter& er)
 {
 	assert(!tokens.empty());
 	if (from >= to)
@@ -865,9 +905,9 @@ PropertyExpression parsePropertyExpression(const vec<LexToken>& tokens, const ui
 
 void parseTypeScope(Universe& universe, const SynBlock* scope, const Identifier& typeIdentifier, ErrorReporter& er)
 {
-	StructType* const scopeType = universe.getType(typeIdentifier.name);
+	StructType* const scopeType = universe.getType(typeIdentifier.symbol);
 	if (!scopeType)
-		er.reportSem(typeIdentifier, typeIdentifier.name + " doesn't name a type.");
+		er.reportSem(typeIdentifier, typeIdentifier.getName() + " doesn't name a type.");
 	for (const auto& statement : scope->getContents())
 	{
 		if (statement->getIsScope())
@@ -875,7 +915,7 @@ void parseTypeScope(Universe& universe, const SynBlock* scope, const Identifier&
 			er.reportSyn(statement->getLineNumber(), "Nested scopes are not allowed.");
 			continue;
 		}
-		const vec<LexToken>& tokens = statement->getTokens();
+		const TokenRange& tokens = statement->getTokens();
 		if (tokens.empty())
 			continue;
 		if (tokens.size() >= 2 && tokens[0].type == LexTokenType::Identifier && tokens[1].type == LexTokenType::Identifier)
@@ -1003,10 +1043,6 @@ void parseTypeScope(Universe& universe, const SynBlock* scope, const Identifier&
 			processPromotion(universe, *scopeType, memberIds, tokens.back(), er);
 			continue;
 		}
-		const auto checkContains = [&tokens](const LexTokenType tokenType)
-		{
-			return std::any_of(tokens.begin(), tokens.end(), [tokenType](const LexToken& token){ return token.type == tokenType; });
-		};
 		const auto splitPropertyExpressionsOn = [&tokens, &er](const LexTokenType tokenType)
 		{
 			uint32_t lastStart = 0;
@@ -1022,22 +1058,22 @@ void parseTypeScope(Universe& universe, const SynBlock* scope, const Identifier&
 			expressions.push_back(parsePropertyExpression(tokens, lastStart, tokens.size(), er));
 			return expressions;
 		};
-		if (checkContains(LexTokenType::Exclusive))
+		if (tokens.contains(LexTokenType::Exclusive))
 		{
 			processExclusivity(*scopeType, splitPropertyExpressionsOn(LexTokenType::Exclusive), er);
 			continue;
 		}
-		if (checkContains(LexTokenType::ExclusiveOr))
+		if (tokens.contains(LexTokenType::ExclusiveOr))
 		{
 			processExclusiveOr(*scopeType, splitPropertyExpressionsOn(LexTokenType::ExclusiveOr), er);
 			continue;
 		}
-		if (checkContains(LexTokenType::Equals))
+		if (tokens.contains(LexTokenType::Equals))
 		{
 			processEquality(*scopeType, splitPropertyExpressionsOn(LexTokenType::Equals), er);
 			continue;
 		}
-		if (checkContains(LexTokenType::Implies))
+		if (tokens.contains(LexTokenType::Implies))
 		{
 			processImplication(*scopeType, splitPropertyExpressionsOn(LexTokenType::Implies), er);
 			continue;
@@ -1046,14 +1082,62 @@ void parseTypeScope(Universe& universe, const SynBlock* scope, const Identifier&
 	}
 }
 
-void parseExampleScope(Universe& /*universe*/, const SynBlock* /*scope*/, const Identifier& /*typeIdentifier*/, ErrorReporter& /*er*/)
+void parseExampleScope(Universe& universe, const SynBlock* scope, const Identifier& typeIdentifier, ErrorReporter& er)
 {
-	// TODO: implement
+	StructType* const exampleType = universe.getType(typeIdentifier.symbol);
+	if (!exampleType)
+	{
+		er.reportSem(typeIdentifier, typeIdentifier.getName() + " doesn't name a type.");
+		return;
+	}
+	Example example;
+	example.lineNumber = scope->getLineNumber();
+	for (const auto& statement : scope->getContents())
+	{
+		if (statement->getIsScope())
+		{
+			er.reportSyn(statement->getLineNumber(), "Nested scopes are not allowed.");
+			continue;
+		}
+		const TokenRange& tokens = statement->getTokens();
+		if (tokens.empty())
+			continue;
+		if (tokens[0].type == LexTokenType::KWName || tokens[0].type == LexTokenType::KWDescription)
+		{
+			if (tokens.size() != 3 || tokens[1].type != LexTokenType::Equals || tokens[2].type != LexTokenType::Literal)
+			{
+				er.reportSyn(tokens[0], "Expected = and a literal after the name or description keyword.");
+				continue;
+			}
+			(tokens[0].type == LexTokenType::KWName ? example.name : example.description) = *tokens[2].content;
+			continue;
+		}
+		// a property of the example, possibly negated, with the members separated by dots or slashes
+		const bool negated = tokens[0].type == LexTokenType::Negate;
+		vec<Identifier> identifiers;
+		bool valid = true;
+		for (uint32_t nxt = negated; nxt < tokens.size() && valid; nxt += 2)
+		{
+			valid = tokens[nxt].type == LexTokenType::Identifier
+				&& (nxt + 1 == tokens.size() || tokens[nxt + 1].type == LexTokenType::Dot || tokens[nxt + 1].type == LexTokenType::Property)
+				&& nxt + 1 != tokens.size() - 1;
+			identifiers.push_back(tokens[nxt]);
+		}
+		if (!valid || identifiers.empty())
+		{
+			er.reportSyn(tokens[0], "Expected a (negated) property of the example type.");
+			continue;
+		}
+		const DeepPropertyHandle handle = getDeepPropertyHandle(*exampleType, identifiers, er);
+		if (handle.pHandle)
+			example.properties.push_back(DeepProperty(handle, negated));
+	}
+	exampleType->addExample(example);
 }
 
 void parseScope(Universe& universe, const SynBlock* scope, ErrorReporter& er)
 {
-	const vec<LexToken>& tokens = scope->getTokens();
+	const TokenRange& tokens = scope->getTokens();
 	if (tokens.empty())
 	{
 		er.reportSyn(scope->getLineNumber(), "Expected description before scope.");
@@ -1101,11 +1185,168 @@ void syntaxAnalysis(Universe& universe, const SynBlock* root, ErrorReporter& er)
 
 void parse(Universe& universe, istream& defs, ErrorReporter& er)
 {
-	vec<LexToken> tokens;
-	tokenize(tokens, defs, er);
+	TokenBuffer tokens(universe.getSymbols());
+	tokenize(tokens, defs, universe.getSymbols(), er);
 
-	uptr<SynBlock> rootBlock = make_unique<SynBlock>(vec<LexToken>(), true, 0);
+	uptr<SynBlock> rootBlock = make_unique<SynBlock>(TokenRange(), true, 0);
 	blockAnalysis(*rootBlock, tokens, er);
 
 	syntaxAnalysis(universe, rootBlock.get(), er);
+}
+
+PropertyRelations parseAssumptions(const StructType& type, istream& expression, ErrorReporter& er)
+{
+	TokenBuffer buffer(type.getSymbols());
+	tokenize(buffer, expression, type.getSymbols(), er);
+	if (buffer.size() == 0)
+		return {};
+	const TokenRange tokens(buffer, 0, buffer.size());
+	const PropertyExpression parsed = parsePropertyExpression(tokens, 0, tokens.size(), er);
+	if (er.getReported())
+		return {};
+	const PropertyRelations relations = propertyExpressionToRelations(type, parsed, er);
+	for (const vec<DeepProperty>& relation : relations)
+	{
+		for (const DeepProperty& property : relation)
+		{
+			if (!property.handle.pHandle && property.negated)
+			{
+				er.reportSem(tokens.front().lineNumber, "A member inequality cannot be assumed.");
+				return {};
+			}
+		}
+	}
+	return relations;
+}
+
+// the name of the type of a type scope or an example scope, or NoSymbol if the scope has no valid description
+Symbol getScopeTypeName(const SynBlock& scope)
+{
+	const TokenRange& tokens = scope.getTokens();
+	if (!tokens.empty() && tokens[0].type == LexTokenType::Identifier)
+		return tokens[0].symbol;
+	if (tokens.size() >= 3 && tokens[0].type == LexTokenType::KWExample && tokens[1].type == LexTokenType::LAngleBra && tokens[2].type == LexTokenType::Identifier)
+		return tokens[2].symbol;
+	return SymbolTable::NoSymbol;
+}
+
+// 64-bit FNV-1a over the bytes
+uint64_t hashBytes(uint64_t hsh, const void* data, const size_t size)
+{
+	const unsigned char* const bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+		hsh = (hsh ^ bytes[i]) * 0x100000001b3ull;
+	return hsh;
+}
+
+// hashes the tokens and the nested blocks with their line numbers relative to the base line;
+// the symbols stand for their texts, since the symbol table keeps them across the reloads
+uint64_t hashBlock(uint64_t hsh, const SynBlock& block, const uint32_t baseLine)
+{
+	const TokenRange& tokens = block.getTokens();
+	const uint32_t header[3] = { block.getIsScope(), uint32_t(tokens.size()), uint32_t(block.getContents().size()) };
+	hsh = hashBytes(hsh, header, sizeof(header));
+	for (uint32_t i = 0; i < tokens.size(); i++)
+	{
+		const LexToken token = tokens[i];
+		const uint32_t fields[3] = { uint32_t(token.type), token.lineNumber - baseLine, token.symbol };
+		hsh = hashBytes(hsh, fields, sizeof(fields));
+	}
+	for (const auto& content : block.getContents())
+		hsh = hashBlock(hsh, *content, baseLine);
+	return hsh;
+}
+
+constexpr uint64_t EmptyHash = 0xcbf29ce484222325ull;
+
+IncrementalParser::IncrementalParser() = default;
+
+IncrementalParser::~IncrementalParser() = default;
+
+void IncrementalParser::analyze(SymbolTable& symbols, const vec<std::string_view>& sources, ErrorReporter& er)
+{
+	roots.clear();
+	buffers.clear();
+	declarationHash = EmptyHash;
+	typeHashes.clear();
+	for (const std::string_view source : sources)
+	{
+		buffers.push_back(make_unique<TokenBuffer>(symbols));
+		tokenize(*buffers.back(), source.data(), source.size(), symbols, er);
+		roots.push_back(make_unique<SynBlock>(TokenRange(), true, 0));
+		blockAnalysis(*roots.back(), *buffers.back(), er);
+		for (const auto& content : roots.back()->getContents())
+		{
+			const Symbol typeName = content->getIsScope() ? getScopeTypeName(*content) : SymbolTable::NoSymbol;
+			if (typeName == SymbolTable::NoSymbol)
+			{
+				declarationHash = hashBlock(declarationHash, *content, content->getLineNumber());
+				continue;
+			}
+			// the examples keep their line numbers, so an example scope that moved is changed
+			const bool example = content->getTokens().front().type == LexTokenType::KWExample;
+			const auto found = typeHashes.find(typeName);
+			typeHashes[typeName] = hashBlock(found == typeHashes.end() ? EmptyHash : found->second, *content, example ? 0 : content->getLineNumber());
+		}
+	}
+}
+
+void IncrementalParser::parse(Universe& universe, const vec<std::string_view>& sources, ErrorReporter& er)
+{
+	analyze(universe.getSymbols(), sources, er);
+	for (const uptr<SynBlock>& root : roots)
+		syntaxAnalysis(universe, root.get(), er);
+}
+
+vec<StructType*> IncrementalParser::reparse(Universe& universe, const vec<std::string_view>& sources, ErrorReporter& er)
+{
+	const uint64_t oldDeclarationHash = declarationHash;
+	const umap<Symbol, uint64_t> oldTypeHashes = std::move(typeHashes);
+	analyze(universe.getSymbols(), sources, er);
+	if (declarationHash != oldDeclarationHash)
+	{
+		universe.clear();
+		for (const uptr<SynBlock>& root : roots)
+			syntaxAnalysis(universe, root.get(), er);
+		vec<StructType*> all;
+		for (const auto& tp : universe.getTypes())
+			all.push_back(tp.get());
+		return all;
+	}
+
+	vec<Symbol> changedNames;
+	for (const auto& entry : typeHashes)
+	{
+		const auto found = oldTypeHashes.find(entry.first);
+		if (found == oldTypeHashes.end() || found->second != entry.second)
+			changedNames.push_back(entry.first);
+	}
+	for (const auto& entry : oldTypeHashes)
+	{
+		if (typeHashes.find(entry.first) == typeHashes.end())
+			changedNames.push_back(entry.first);
+	}
+	vec<StructType*> changed;
+	for (const Symbol name : changedNames)
+	{
+		if (StructType* const type = universe.getType(name))
+			changed.push_back(type);
+	}
+	const vec<StructType*> reset = universe.resetDependents(changed);
+
+	// the scopes are parsed again in the order of the sources, so the members are parsed before the types that contain them
+	for (const uptr<SynBlock>& root : roots)
+	{
+		for (const auto& content : root->getContents())
+		{
+			if (!content->getIsScope())
+				continue;
+			const Symbol typeName = getScopeTypeName(*content);
+			const StructType* const type = universe.getType(typeName);
+			// the scopes of the unknown types are parsed again only to report them
+			if (type ? std::find(reset.begin(), reset.end(), type) != reset.end() : std::find(changedNames.begin(), changedNames.end(), typeName) != changedNames.end())
+				parseScope(universe, content.get(), er);
+		}
+	}
+	return reset;
 }
\ No newline at end of file
@@ -1,10 +1,48 @@
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
+#include <string_view>
 
+#include "ptr.hpp"
+#include "str.hpp"
+#include "umap.hpp"
 #include "universe.hpp"
+#include "vec.hpp"
 
 using std::istream;
 using std::ostream;
 
-void parse(Universe& universe, istream& defs, ErrorReporter& er);
\ No newline at end of file
+void parse(Universe& universe, istream& defs, ErrorReporter& er);
+
+// parses a property expression over the deep properties of the type into the relations that a counting query assumes
+PropertyRelations parseAssumptions(const StructType& type, istream& expression, ErrorReporter& er);
+
+class SynBlock;
+
+// Parses sources into a universe and keeps their scopes with a content hash per type, so that edited sources are reloaded
+// by re-parsing only the scopes of the types that changed and of the types that depend on them.
+// The hash of a type covers its type scopes and its example scopes with their line numbers, since the examples keep them.
+class IncrementalParser
+{
+public:
+	IncrementalParser();
+	~IncrementalParser();
+
+	// parses the sources in order, e.g. the types and the examples, as parse does; the sources may be e.g. mapped files,
+	// they are not referred to once parsed, the tokens are kept with their names interned into the symbols of the universe
+	void parse(Universe& universe, const vec<std::string_view>& sources, ErrorReporter& er);
+	// parses the edited sources and returns the types that were reset and parsed again, which are to be preprocessed again;
+	// if the statements outside the type and example scopes changed, the universe is parsed anew and all its types are returned
+	vec<StructType*> reparse(Universe& universe, const vec<std::string_view>& sources, ErrorReporter& er);
+
+private:
+	vec<uptr<SynBlock>> roots;
+	// the tokens of the sources, which the blocks refer to
+	vec<uptr<TokenBuffer>> buffers;
+	// the hash of the type declarations and the scopes without a type
+	uint64_t declarationHash = 0;
+	umap<Symbol, uint64_t> typeHashes;
+
+	void analyze(SymbolTable& symbols, const vec<std::string_view>& sources, ErrorReporter& er);
+};
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vec.hpp"
+
+// Values of a subset of the deep properties (flat indices) of a type, packed 64 properties per word.
+class PartialAssignment
+{
+public:
+	PartialAssignment() = default;
+	PartialAssignment(const uint32_t variableCount) : variableCount(variableCount), specified((variableCount + 63) / 64, 0), values((variableCount + 63) / 64, 0)
+	{
+	}
+
+	uint32_t getVariableCount() const
+	{
+		return variableCount;
+	}
+
+	bool isSpecified(const uint32_t variable) const
+	{
+		return (specified[variable >> 6] >> (variable & 63)) & 1;
+	}
+
+	bool getValue(const uint32_t variable) const
+	{
+		return (values[variable >> 6] >> (variable & 63)) & 1;
+	}
+
+	// whether the property may take the value
+	bool allows(const uint32_t variable, const bool value) const
+	{
+		return !isSpecified(variable) || getValue(variable) == value;
+	}
+
+	void set(const uint32_t variable, const bool value)
+	{
+		const uint64_t bit = uint64_t(1) << (variable & 63);
+		specified[variable >> 6] |= bit;
+		if (value)
+			values[variable >> 6] |= bit;
+		else
+			values[variable >> 6] &= ~bit;
+	}
+
+	void unset(const uint32_t variable)
+	{
+		specified[variable >> 6] &= ~(uint64_t(1) << (variable & 63));
+		values[variable >> 6] &= ~(uint64_t(1) << (variable & 63));
+	}
+
+	const vec<uint64_t>& getSpecifiedWords() const
+	{
+		return specified;
+	}
+
+	const vec<uint64_t>& getValueWords() const
+	{
+		return values;
+	}
+
+private:
+	uint32_t variableCount = 0;
+	vec<uint64_t> specified;
+	vec<uint64_t> values;
+};
\ No newline at end of file
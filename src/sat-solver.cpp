@@ -0,0 +1,340 @@
+#include "sat-solver.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// the i-th element (from 0) of the Luby sequence 1, 1, 2, 1, 1, 2, 4, ...
+static uint32_t luby(uint32_t i)
+{
+	uint32_t size = 1;
+	uint32_t power = 1;
+	while (size < i + 1)
+	{
+		size = 2 * size + 1;
+		power *= 2;
+	}
+	while (size - 1 != i)
+	{
+		size = (size - 1) / 2;
+		power /= 2;
+		i %= size;
+	}
+	return power;
+}
+
+SatSolver::SatSolver(const uint32_t variableCount)
+	: variableCount(variableCount), learnedLimit(1000), watches(variableCount * 2), values(variableCount, Unset), levels(variableCount, 0),
+	reasons(variableCount, NoClause), activity(variableCount, 0), phases(variableCount, 0), seen(variableCount, 0), model(variableCount, 0)
+{
+}
+
+uint32_t SatSolver::getVariableCount() const
+{
+	return variableCount;
+}
+
+size_t SatSolver::getConflictCount() const
+{
+	return conflictCount;
+}
+
+size_t SatSolver::getLearnedCount() const
+{
+	return learnedCount;
+}
+
+bool SatSolver::getModelValue(const uint32_t variable) const
+{
+	return model[variable];
+}
+
+bool SatSolver::addClause(vec<uint32_t> literals)
+{
+	cancelUntil(0);
+	if (!consistent)
+		return false;
+	std::sort(literals.begin(), literals.end());
+	literals.erase(std::unique(literals.begin(), literals.end()), literals.end());
+	uint32_t kept = 0;
+	for (uint32_t li = 0; li < literals.size(); li++)
+	{
+		// a clause with complementary literals or a literal true at the root is satisfied
+		if (isTrue(literals[li]) || (li + 1 < literals.size() && literals[li + 1] == (literals[li] ^ 1)))
+			return true;
+		if (!isFalse(literals[li]))
+			literals[kept++] = literals[li];
+	}
+	literals.resize(kept);
+	if (literals.empty())
+		consistent = false;
+	else if (literals.size() == 1)
+	{
+		enqueue(literals[0], NoClause);
+		consistent = propagate() == NoClause;
+	}
+	else
+		addWatchedClause(literals, false);
+	learnedLimit = std::max(learnedLimit, clauses.size());
+	return consistent;
+}
+
+uint32_t SatSolver::addWatchedClause(vec<uint32_t> literals, const bool isLearned)
+{
+	const uint32_t clause = clauses.size();
+	watches[literals[0]].push_back(clause);
+	watches[literals[1]].push_back(clause);
+	clauses.push_back(std::move(literals));
+	learned.push_back(isLearned);
+	if (isLearned)
+		learnedCount++;
+	return clause;
+}
+
+void SatSolver::enqueue(const uint32_t literal, const uint32_t reason)
+{
+	const uint32_t variable = literal >> 1;
+	values[variable] = !(literal & 1);
+	levels[variable] = getDecisionLevel();
+	reasons[variable] = reason;
+	trail.push_back(literal);
+}
+
+void SatSolver::cancelUntil(const uint32_t level)
+{
+	if (getDecisionLevel() <= level)
+		return;
+	for (uint32_t ti = trail.size(); ti > trailLimits[level]; ti--)
+	{
+		const uint32_t variable = trail[ti - 1] >> 1;
+		phases[variable] = values[variable];
+		values[variable] = Unset;
+		reasons[variable] = NoClause;
+	}
+	trail.resize(trailLimits[level]);
+	trailLimits.resize(level);
+	propagationHead = std::min<uint32_t>(propagationHead, trail.size());
+}
+
+uint32_t SatSolver::propagate()
+{
+	while (propagationHead < trail.size())
+	{
+		const uint32_t falseLiteral = trail[propagationHead++] ^ 1;
+		vec<uint32_t>& watching = watches[falseLiteral];
+		uint32_t kept = 0;
+		for (uint32_t wi = 0; wi < watching.size(); wi++)
+		{
+			const uint32_t clause = watching[wi];
+			vec<uint32_t>& literals = clauses[clause];
+			if (literals[0] == falseLiteral)
+				std::swap(literals[0], literals[1]);
+			if (isTrue(literals[0]))
+			{
+				watching[kept++] = clause;
+				continue;
+			}
+			uint32_t replacement = 2;
+			while (replacement < literals.size() && isFalse(literals[replacement]))
+				replacement++;
+			if (replacement < literals.size())
+			{
+				std::swap(literals[1], literals[replacement]);
+				watches[literals[1]].push_back(clause);
+				continue;
+			}
+			watching[kept++] = clause;
+			if (isFalse(literals[0]))
+			{
+				while (++wi < watching.size())
+					watching[kept++] = watching[wi];
+				watching.resize(kept);
+				propagationHead = trail.size();
+				return clause;
+			}
+			enqueue(literals[0], clause);
+		}
+		watching.resize(kept);
+	}
+	return NoClause;
+}
+
+uint32_t SatSolver::analyze(uint32_t conflict, vec<uint32_t>& learnedClause)
+{
+	// resolves the conflict with the reasons of the current level until a single literal of the level is left (the first UIP)
+	learnedClause.assign(1, 0);
+	uint32_t pathCount = 0;
+	uint32_t ti = trail.size();
+	bool first = true;
+	uint32_t literal = 0;
+	do
+	{
+		const vec<uint32_t>& literals = clauses[conflict];
+		for (uint32_t li = first ? 0 : 1; li < literals.size(); li++)
+		{
+			const uint32_t variable = literals[li] >> 1;
+			if (seen[variable] || levels[variable] == 0)
+				continue;
+			seen[variable] = 1;
+			bump(variable);
+			if (levels[variable] == getDecisionLevel())
+				pathCount++;
+			else
+				learnedClause.push_back(literals[li]);
+		}
+		first = false;
+		while (!seen[trail[ti - 1] >> 1])
+			ti--;
+		literal = trail[--ti];
+		conflict = reasons[literal >> 1];
+		seen[literal >> 1] = 0;
+		pathCount--;
+	} while (pathCount > 0);
+	learnedClause[0] = literal ^ 1;
+
+	uint32_t backtrackLevel = 0;
+	for (uint32_t li = 1; li < learnedClause.size(); li++)
+	{
+		seen[learnedClause[li] >> 1] = 0;
+		if (levels[learnedClause[li] >> 1] > backtrackLevel)
+		{
+			backtrackLevel = levels[learnedClause[li] >> 1];
+			std::swap(learnedClause[1], learnedClause[li]);
+		}
+	}
+	return backtrackLevel;
+}
+
+void SatSolver::bump(const uint32_t variable)
+{
+	activity[variable] += activityIncrement;
+	if (activity[variable] > 1e100)
+	{
+		for (double& value : activity)
+			value *= 1e-100;
+		activityIncrement *= 1e-100;
+	}
+}
+
+uint32_t SatSolver::pickBranchVariable() const
+{
+	// the types have at most a few hundred properties, so a scan is cheaper than maintaining a heap
+	uint32_t best = variableCount;
+	for (uint32_t variable = 0; variable < variableCount; variable++)
+	{
+		if (values[variable] == Unset && (best == variableCount || activity[variable] > activity[best]))
+			best = variable;
+	}
+	return best;
+}
+
+void SatSolver::reduceLearned()
+{
+	// at the root, so no learned clause is the reason of an assignment that can be undone;
+	// the longer half of the learned clauses is dropped, the binary ones are always kept
+	assert(getDecisionLevel() == 0);
+	vec<uint32_t> sizes;
+	for (uint32_t clause = 0; clause < clauses.size(); clause++)
+	{
+		if (learned[clause] && clauses[clause].size() > 2)
+			sizes.push_back(clauses[clause].size());
+	}
+	if (sizes.empty())
+		return;
+	std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+	const uint32_t median = sizes[sizes.size() / 2];
+	uint32_t kept = 0;
+	for (uint32_t clause = 0; clause < clauses.size(); clause++)
+	{
+		if (learned[clause] && clauses[clause].size() > 2 && clauses[clause].size() >= median)
+		{
+			learnedCount--;
+			continue;
+		}
+		clauses[kept] = std::move(clauses[clause]);
+		learned[kept] = learned[clause];
+		kept++;
+	}
+	clauses.resize(kept);
+	learned.resize(kept);
+	for (vec<uint32_t>& watching : watches)
+		watching.clear();
+	for (uint32_t clause = 0; clause < clauses.size(); clause++)
+	{
+		watches[clauses[clause][0]].push_back(clause);
+		watches[clauses[clause][1]].push_back(clause);
+	}
+	// the reasons of the root assignments are never analyzed
+	for (const uint32_t literal : trail)
+		reasons[literal >> 1] = NoClause;
+}
+
+bool SatSolver::solve(const vec<uint32_t>& assumptions)
+{
+	cancelUntil(0);
+	if (!consistent)
+		return false;
+	size_t restartLimit = conflictCount + 100 * luby(restartIndex);
+	vec<uint32_t> learnedClause;
+	while (true)
+	{
+		const uint32_t conflict = propagate();
+		if (conflict != NoClause)
+		{
+			conflictCount++;
+			if (getDecisionLevel() == 0)
+			{
+				consistent = false;
+				return false;
+			}
+			const uint32_t backtrackLevel = analyze(conflict, learnedClause);
+			cancelUntil(backtrackLevel);
+			if (learnedClause.size() == 1)
+				enqueue(learnedClause[0], NoClause);
+			else
+				enqueue(learnedClause[0], addWatchedClause(learnedClause, true));
+			activityIncrement /= 0.95;
+			continue;
+		}
+		if (conflictCount >= restartLimit)
+		{
+			cancelUntil(0);
+			if (learnedCount > learnedLimit)
+			{
+				reduceLearned();
+				learnedLimit += learnedLimit / 10;
+			}
+			restartLimit = conflictCount + 100 * luby(++restartIndex);
+			continue;
+		}
+		uint32_t decision = NoClause;
+		while (getDecisionLevel() < assumptions.size())
+		{
+			// an assumption that already holds gets an empty level, so the levels keep matching the assumptions
+			const uint32_t assumption = assumptions[getDecisionLevel()];
+			if (isFalse(assumption))
+			{
+				cancelUntil(0);
+				return false;
+			}
+			trailLimits.push_back(trail.size());
+			if (!isTrue(assumption))
+			{
+				decision = assumption;
+				break;
+			}
+		}
+		if (decision == NoClause)
+		{
+			const uint32_t variable = pickBranchVariable();
+			if (variable == variableCount)
+			{
+				model.assign(values.begin(), values.end());
+				cancelUntil(0);
+				return true;
+			}
+			trailLimits.push_back(trail.size());
+			decision = variable << 1 | !phases[variable];
+		}
+		enqueue(decision, NoClause);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "vec.hpp"
+
+// Conflict-driven clause-learning solver over a fixed set of variables.
+// Literals are encoded as (variable << 1 | negated). The assumptions of a query are its first decisions,
+// so the learned clauses only depend on the added clauses and are kept for the following queries.
+class SatSolver
+{
+public:
+	SatSolver(uint32_t variableCount);
+
+	// returns false if the clauses became unsatisfiable
+	bool addClause(vec<uint32_t> literals);
+	// whether the clauses have a model in which all the assumed literals are true
+	bool solve(const vec<uint32_t>& assumptions);
+	// the value of the variable in the last model found
+	bool getModelValue(uint32_t variable) const;
+
+	uint32_t getVariableCount() const;
+	size_t getConflictCount() const;
+	size_t getLearnedCount() const;
+
+private:
+	static constexpr uint32_t NoClause = std::numeric_limits<uint32_t>::max();
+	static constexpr uint8_t Unset = 2;
+
+	uint32_t variableCount;
+	bool consistent = true;
+
+	// the first two literals of a clause are the watched ones
+	vec<vec<uint32_t>> clauses;
+	vec<bool> learned;
+	size_t learnedCount = 0;
+	size_t learnedLimit;
+	// for every literal, the clauses in which it is watched
+	vec<vec<uint32_t>> watches;
+
+	vec<uint8_t> values;
+	vec<uint32_t> levels;
+	vec<uint32_t> reasons;
+	// the true literals in the order of their assignment, with the start of every decision level
+	vec<uint32_t> trail;
+	vec<uint32_t> trailLimits;
+	uint32_t propagationHead = 0;
+
+	vec<double> activity;
+	double activityIncrement = 1;
+	vec<uint8_t> phases;
+	vec<uint8_t> seen;
+	vec<uint8_t> model;
+
+	size_t conflictCount = 0;
+	uint32_t restartIndex = 0;
+
+	bool isTrue(const uint32_t literal) const
+	{
+		return values[literal >> 1] != Unset && values[literal >> 1] != (literal & 1);
+	}
+
+	bool isFalse(const uint32_t literal) const
+	{
+		return values[literal >> 1] == (literal & 1);
+	}
+
+	uint32_t getDecisionLevel() const
+	{
+		return trailLimits.size();
+	}
+
+	void enqueue(uint32_t literal, uint32_t reason);
+	void cancelUntil(uint32_t level);
+	uint32_t addWatchedClause(vec<uint32_t> literals, bool isLearned);
+	uint32_t propagate();
+	uint32_t analyze(uint32_t conflict, vec<uint32_t>& learnedClause);
+	void bump(uint32_t variable);
+	uint32_t pickBranchVariable() const;
+	void reduceLearned();
+};
\ No newline at end of file
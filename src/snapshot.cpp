@@ -0,0 +1,167 @@
+#include "snapshot.hpp"
+
+SnapshotWriter::SnapshotWriter(std::ostream& output) : output(&output)
+{
+}
+
+void SnapshotWriter::writeWord(const uint32_t word)
+{
+	const char bytes[4] = { char(word), char(word >> 8), char(word >> 16), char(word >> 24) };
+	output->write(bytes, 4);
+}
+
+void SnapshotWriter::writeWide(const uint64_t wide)
+{
+	writeWord(uint32_t(wide));
+	writeWord(uint32_t(wide >> 32));
+}
+
+void SnapshotWriter::writeString(const str& string)
+{
+	writeWord(string.size());
+	output->write(string.data(), string.size());
+	// the strings are padded to whole words
+	output->write("\0\0\0", (4 - string.size() % 4) % 4);
+}
+
+void SnapshotWriter::writeWords(const vec<uint32_t>& words)
+{
+	writeWords(words.data(), words.size());
+}
+
+void SnapshotWriter::writeWords(const uint32_t* words, const size_t count)
+{
+	writeWord(count);
+	for (size_t wi = 0; wi < count; wi++)
+		writeWord(words[wi]);
+}
+
+void SnapshotWriter::writeWordLists(const vec<vec<uint32_t>>& lists)
+{
+	writeWord(lists.size());
+	for (const vec<uint32_t>& words : lists)
+		writeWords(words);
+}
+
+void SnapshotWriter::writePairLists(const vec<vec<pair<uint32_t, uint32_t>>>& lists)
+{
+	writeWord(lists.size());
+	for (const vec<pair<uint32_t, uint32_t>>& pairs : lists)
+	{
+		writeWord(pairs.size());
+		for (const pair<uint32_t, uint32_t>& pr : pairs)
+		{
+			writeWord(pr.first);
+			writeWord(pr.second);
+		}
+	}
+}
+
+SnapshotReader::SnapshotReader(const char* data, const size_t size) : data(reinterpret_cast<const unsigned char*>(data)), size(size)
+{
+}
+
+uint32_t SnapshotReader::readWord()
+{
+	if (!valid || size - position < 4)
+	{
+		valid = false;
+		return 0;
+	}
+	const unsigned char* const bytes = data + position;
+	position += 4;
+	return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+uint64_t SnapshotReader::readWide()
+{
+	const uint64_t low = readWord();
+	return low | uint64_t(readWord()) << 32;
+}
+
+str SnapshotReader::readString()
+{
+	const uint32_t length = readWord();
+	const size_t padded = (size_t(length) + 3) / 4 * 4;
+	if (!valid || size - position < padded)
+	{
+		valid = false;
+		return "";
+	}
+	const str string(reinterpret_cast<const char*>(data + position), length);
+	position += padded;
+	return string;
+}
+
+uint32_t SnapshotReader::readLength(const uint32_t itemWords)
+{
+	const uint32_t length = readWord();
+	if (valid && uint64_t(length) * itemWords * 4 <= size - position)
+		return length;
+	valid = false;
+	return 0;
+}
+
+vec<uint32_t> SnapshotReader::readWords()
+{
+	vec<uint32_t> words(readLength(1));
+	for (uint32_t& word : words)
+		word = readWord();
+	return words;
+}
+
+const uint32_t* SnapshotReader::viewWords(uint32_t& count)
+{
+	// the words are stored little-endian, so they are used in place only on such hosts and if they are aligned
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	const size_t start = position;
+	count = readLength(1);
+	if (valid && reinterpret_cast<uintptr_t>(data + position) % alignof(uint32_t) == 0)
+	{
+		const uint32_t* const words = reinterpret_cast<const uint32_t*>(data + position);
+		position += size_t(count) * 4;
+		return words;
+	}
+	position = start;
+#endif
+	count = 0;
+	return nullptr;
+}
+
+vec<vec<uint32_t>> SnapshotReader::readWordLists()
+{
+	vec<vec<uint32_t>> lists(readLength(1));
+	for (vec<uint32_t>& words : lists)
+		words = readWords();
+	return lists;
+}
+
+vec<vec<pair<uint32_t, uint32_t>>> SnapshotReader::readPairLists()
+{
+	vec<vec<pair<uint32_t, uint32_t>>> lists(readLength(1));
+	for (vec<pair<uint32_t, uint32_t>>& pairs : lists)
+	{
+		pairs.resize(readLength(2));
+		for (pair<uint32_t, uint32_t>& pr : pairs)
+		{
+			pr.first = readWord();
+			pr.second = readWord();
+		}
+	}
+	return lists;
+}
+
+bool SnapshotReader::isValid() const
+{
+	return valid;
+}
+
+bool SnapshotReader::isAtEnd() const
+{
+	return position == size;
+}
+
+void SnapshotReader::invalidate()
+{
+	valid = false;
+}
\ No newline at end of file
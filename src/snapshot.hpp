@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "str.hpp"
+#include "vec.hpp"
+
+using std::pair;
+
+// Writes the words of a snapshot as 32-bit little-endian integers, the lists prefixed by their lengths.
+class SnapshotWriter
+{
+public:
+	SnapshotWriter(std::ostream& output);
+
+	void writeWord(uint32_t word);
+	// a 64-bit number as two words, the low one first
+	void writeWide(uint64_t wide);
+	void writeString(const str& string);
+	void writeWords(const vec<uint32_t>& words);
+	void writeWords(const uint32_t* words, size_t count);
+	void writeWordLists(const vec<vec<uint32_t>>& lists);
+	void writePairLists(const vec<vec<pair<uint32_t, uint32_t>>>& lists);
+
+private:
+	std::ostream* output;
+};
+
+// Reads a snapshot from memory. Reading past the end or a list longer than the rest of the data
+// invalidates the reader, which then returns zeros and empty lists, so a damaged file is detected once it was read.
+class SnapshotReader
+{
+public:
+	SnapshotReader(const char* data, size_t size);
+
+	uint32_t readWord();
+	uint64_t readWide();
+	str readString();
+	vec<uint32_t> readWords();
+	// the words of a list in place, valid as long as the data; null if they cannot be used in place,
+	// then the list is read by readWords
+	const uint32_t* viewWords(uint32_t& count);
+	vec<vec<uint32_t>> readWordLists();
+	vec<vec<pair<uint32_t, uint32_t>>> readPairLists();
+	// a length of a list of items of at least the given number of words, or 0 if the data cannot contain it
+	uint32_t readLength(uint32_t itemWords);
+
+	bool isValid() const;
+	bool isAtEnd() const;
+	// marks the data as invalid, e.g. when a read index is out of its range
+	void invalidate();
+
+private:
+	const unsigned char* data;
+	size_t size;
+	size_t position = 0;
+	bool valid = true;
+};
\ No newline at end of file
@@ -2,16 +2,41 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
 #include <unordered_set>
 
+#include "approximate-counter.hpp"
+#include "instance-counter.hpp"
 #include "print.hpp"
+#include "snapshot.hpp"
+#include "union-find.hpp"
 
-str StructType::getName() const
+StructType::StructType(const Symbol name, SymbolTable& symbols) : symbols(&symbols), name(name), assumedCounter(make_unique<AssumedCounter>())
+{
+}
+
+StructType::StructType(StructType&& type) = default;
+
+StructType& StructType::operator=(StructType&& type) = default;
+
+StructType::~StructType() = default;
+
+const str& StructType::getName() const
+{
+	return symbols->getName(name);
+}
+
+Symbol StructType::getSymbol() const
 {
 	return name;
 }
 
-PropertyHandle StructType::addProperty(const str& name)
+SymbolTable& StructType::getSymbols() const
+{
+	return *symbols;
+}
+
+PropertyHandle StructType::addProperty(const Symbol name)
 {
 	assert(getProperty(name) == NoProperty);
 	
@@ -21,19 +46,18 @@ PropertyHandle StructType::addProperty(const str& name)
 	return handle;
 }
 
-PropertyHandle StructType::getProperty(const str& name) const
+PropertyHandle StructType::getProperty(const Symbol name) const
 {
-	if (propertyMap.find(name) != propertyMap.end())
-		return propertyMap.at(name);
-	return NoProperty;
+	const auto found = propertyMap.find(name);
+	return found == propertyMap.end() ? NoProperty : found->second;
 }
 
-str StructType::getPropertyName(const PropertyHandle handle) const
+const str& StructType::getPropertyName(const PropertyHandle handle) const
 {
 	assert(handle > 0);
 	assert(handle <= properties.size());
 
-	return properties[handle - 1];
+	return symbols->getName(properties[handle - 1]);
 }
 
 size_t StructType::getPropertyCount() const
@@ -43,10 +67,8 @@ size_t StructType::getPropertyCount() const
 
 size_t StructType::getDeepPropertyFullCount() const
 {
-	size_t sm = getPropertyCount();
-	for (const auto& m : members)
-		sm += m.second->getDeepPropertyFullCount();
-	return sm;
+	assert(preprocessed);
+	return deepPropertyFullCount;
 }
 
 size_t StructType::getDeepPropertyDistinctCount() const
@@ -54,7 +76,16 @@ size_t StructType::getDeepPropertyDistinctCount() const
 	return deepPropertyGroups.size();
 }
 
-MemberHandle StructType::addMember(const str& name, StructType* const type)
+str StructType::getDeepPropertyName(const uint32_t index) const
+{
+	const pair<uint32_t, uint32_t>& representative = deepPropertyGroups[index].front();
+	if (representative.first == 0)
+		return symbols->getName(properties[representative.second]);
+	const pair<Symbol, StructType*>& member = members[representative.first - 1];
+	return symbols->getName(member.first) + "." + member.second->getDeepPropertyName(representative.second);
+}
+
+MemberHandle StructType::addMember(const Symbol name, StructType* const type)
 {
 	assert(getMember(name) == NoMember);
 
@@ -64,18 +95,10 @@ MemberHandle StructType::addMember(const str& name, StructType* const type)
 	return handle;
 }
 
-MemberHandle StructType::getMember(const str& name) const
+MemberHandle StructType::getMember(const Symbol name) const
 {
-	if (memberMap.find(name) != memberMap.end())
-		return memberMap.at(name);
-	return NoMember;
-}
-
-const StructType* StructType::getMemberType(const str& name) const
-{
-	assert(getMember(name) != NoMember);
-
-	return getMemberType(getMember(name));
+	const auto found = memberMap.find(name);
+	return found == memberMap.end() ? NoMember : found->second;
 }
 
 const StructType* StructType::getMemberType(const MemberHandle handle) const
@@ -86,12 +109,12 @@ const StructType* StructType::getMemberType(const MemberHandle handle) const
 	return members[handle - 1].second;
 }
 
-str StructType::getMemberName(const MemberHandle handle) const
+const str& StructType::getMemberName(const MemberHandle handle) const
 {
 	assert(handle > 0);
 	assert(handle <= members.size());
 
-	return members[handle - 1].first;
+	return symbols->getName(members[handle - 1].first);
 }
 
 size_t StructType::getMemberCount() const
@@ -101,10 +124,8 @@ size_t StructType::getMemberCount() const
 
 size_t StructType::getDeepMemberFullCount() const
 {
-	size_t sm = getMemberCount();
-	for (const auto& m : members)
-		sm += m.second->getDeepMemberFullCount();
-	return sm;
+	assert(preprocessed);
+	return deepMemberFullCount;
 }
 
 size_t StructType::getDeepMemberDistinctCount() const
@@ -147,20 +168,59 @@ void StructType::addPromotion(const DeepPropertyHandle& propertyHandle, const St
 	rawPromotions.push_back({ propertyHandle, promoteTo });
 }
 
-bool StructType::isNameUsed(const str& name) const
+void StructType::addExample(const Example& example)
+{
+	examples.push_back(example);
+}
+
+const vec<Example>& StructType::getExamples() const
+{
+	return examples;
+}
+
+bool StructType::isNameUsed(const Symbol name) const
 {
 	return getMember(name) || getProperty(name);
 }
 
-void StructType::preprocess()
+bool StructType::dependsOn(const StructType* type) const
+{
+	for (const auto& m : members)
+	{
+		if (m.second == type)
+			return true;
+	}
+	for (const pair<DeepPropertyHandle, const StructType*>& promotion : rawPromotions)
+	{
+		if (promotion.second == type)
+			return true;
+	}
+	return false;
+}
+
+void StructType::reset()
+{
+	*this = StructType(name, *symbols);
+}
+
+void StructType::preprocess(const SimplificationOptions& options)
 {
 	for (const auto& m : members)
 		if (!m.second->preprocessed)
-			m.second->preprocess();
+			m.second->preprocess(options);
+
+	deepPropertyFullCount = getPropertyCount();
+	deepMemberFullCount = getMemberCount();
+	for (const auto& m : members)
+	{
+		deepPropertyFullCount += m.second->deepPropertyFullCount;
+		deepMemberFullCount += m.second->deepMemberFullCount;
+	}
 	
 	// preprocess local and child properties & members
 	preprocessMemberEqualities();
 	preprocessPropertyEqualities();
+	buildPathNodes();
 
 	// preprocess promotion clusters (adding properties that are not included in children (or locallly) to types)
 
@@ -168,9 +228,12 @@ void StructType::preprocess()
 
 	// preprocess relations
 
-	preprocessChildPromotions();
+	vec<vec<FlatProperty>> flat;
+	preprocessChildPromotions(flat);
 	preprocessOwnPromotions();
-	preprocessRelations();
+	preprocessRelations(flat);
+	simplifyRelations(flat, options);
+	preprocessExamples();
 	
 	preprocessed = true;
 }
@@ -182,7 +245,12 @@ bool StructType::isPreprocessed() const
 
 size_t StructType::getFlatRelationCount() const
 {
-	return flatRelations.size();
+	return flatRelations.getClauseCount();
+}
+
+const SimplificationStats& StructType::getSimplificationStats() const
+{
+	return simplificationStats;
 }
 
 size_t StructType::getPossibleInstancesCount() const
@@ -197,14 +265,151 @@ size_t StructType::getPossibleInstancesCount() const
 			cout << (property.negated ? "~" : "") << property.handle.pHandle - 1 << " ";
 		}
 	}
-	for (const vec<FlatProperty>& relation : flatRelations)
+	for (uint32_t clause = 0; clause < flatRelations.getClauseCount(); clause++)
 	{
 		cout << endl;
-		for (const FlatProperty& property : relation)
-			cout << (property.negated ? "~" : "") << property.index << " ";
+		for (const uint32_t literal : flatRelations[clause])
+			cout << (literal & 1 ? "~" : "") << (literal >> 1) << " ";
 	}
 	*/
-	return getPossibleInstancesCount(vec<bool>(deepPropertyGroups.size(), false), vec<bool>(deepPropertyGroups.size()));
+	return possibleInstancesCount != NoCount ? possibleInstancesCount : InstanceCounter(*this).count();
+}
+
+// splits the models of the clauses over the properties they mention into disjoint partial assignments extending the given one
+static void splitAssumptions(const vec<vec<FlatProperty>>& clauses, PartialAssignment& assignment, vec<PartialAssignment>& cubes)
+{
+	for (const vec<FlatProperty>& clause : clauses)
+	{
+		bool satisfied = false;
+		uint32_t branchVariable = 0;
+		bool unassigned = false;
+		for (const FlatProperty& property : clause)
+		{
+			if (!assignment.isSpecified(property.index))
+			{
+				branchVariable = property.index;
+				unassigned = true;
+			}
+			else if (assignment.getValue(property.index) != property.negated)
+				satisfied = true;
+		}
+		if (satisfied)
+			continue;
+		if (!unassigned)
+			return;
+		for (const bool value : { false, true })
+		{
+			assignment.set(branchVariable, value);
+			splitAssumptions(clauses, assignment, cubes);
+		}
+		assignment.unset(branchVariable);
+		return;
+	}
+	cubes.push_back(assignment);
+}
+
+size_t StructType::getPossibleInstancesCount(const PropertyRelations& assumptions) const
+{
+	// the assumptions are split into disjoint partial assignments that are counted one by one
+	// by the circuits or by the counters kept by the types, so the relations and the caches are shared by all the queries
+	vec<vec<FlatProperty>> flatAssumptions;
+	for (const vec<DeepProperty>& relation : assumptions)
+		flattenRelation(relation, flatAssumptions);
+	PartialAssignment assignment(getDeepPropertyDistinctCount());
+	vec<PartialAssignment> cubes;
+	splitAssumptions(flatAssumptions, assignment, cubes);
+	size_t total = 0;
+	for (const PartialAssignment& cube : cubes)
+		total += countAssumed(cube);
+	return total;
+}
+
+bool Promotion::project(const PartialAssignment& assignment, PartialAssignment& projected) const
+{
+	projected = PartialAssignment(target->getDeepPropertyDistinctCount());
+	for (uint32_t variable = 0; variable < assignment.getVariableCount(); variable++)
+	{
+		if (!assignment.isSpecified(variable))
+			continue;
+		if (!projected.allows(propertyMap[variable], assignment.getValue(variable)))
+			return false;
+		projected.set(propertyMap[variable], assignment.getValue(variable));
+	}
+	return true;
+}
+
+size_t StructType::countAssumed(const PartialAssignment& assumptions) const
+{
+	// an instance with a promoted property is an instance of the type it promotes to, so a promoted property assumed true
+	// leaves only the instances of its target (and of the targets of the undecided promotions before it)
+	PartialAssignment current = assumptions;
+	size_t total = 0;
+	for (const Promotion& promotion : promotions)
+	{
+		const bool assumedTrue = current.isSpecified(promotion.property) && current.getValue(promotion.property);
+		if (current.isSpecified(promotion.property) && !assumedTrue)
+			continue;
+		PartialAssignment projected;
+		const bool consistent = promotion.project(current, projected);
+		if (consistent)
+			total += promotion.target->countAssumed(projected);
+		if (assumedTrue)
+			return total;
+		current.set(promotion.property, false);
+	}
+	// all the promoted properties are false, so the count of the type itself does not expand the promotions again
+	if (circuit)
+		return total + circuit->count(current);
+	const std::lock_guard<std::mutex> lock(assumedCounter->mutex);
+	if (!assumedCounter->counter)
+		assumedCounter->counter = make_unique<InstanceCounter>(*this);
+	return total + assumedCounter->counter->count(current);
+}
+
+double StructType::getApproximateInstancesCount(const double tolerance, const double confidence) const
+{
+	ApproximationOptions options;
+	options.tolerance = tolerance;
+	options.confidence = confidence;
+	return ApproximateCounter(*this, options).count();
+}
+
+void StructType::compile()
+{
+	assert(preprocessed);
+	circuit = InstanceCounter(*this).compile();
+}
+
+bool StructType::isCompiled() const
+{
+	return circuit != nullptr;
+}
+
+void StructType::storePossibleInstancesCount()
+{
+	assert(circuit);
+	possibleInstancesCount = circuit->count();
+}
+
+const InstanceCircuit* StructType::getCircuit() const
+{
+	return circuit.get();
+}
+
+void StructType::buildImplicationIndex()
+{
+	assert(preprocessed);
+	implicationIndex = make_unique<ImplicationIndex>(*this);
+}
+
+const ImplicationIndex* StructType::getImplicationIndex() const
+{
+	return implicationIndex.get();
+}
+
+const vec<Promotion>& StructType::getPromotions() const
+{
+	return promotions;
 }
 
 void StructType::precheck(ErrorReporter& er) const
@@ -228,190 +433,161 @@ const StructType* StructType::getDeepMemberType(const DeepMemberHandle& handle)
 	return type;
 }
 
-uint32_t StructType::getDeepMemberGroup(const DeepMemberHandle& handle) const
-{
-	assert(!handle.empty());
-	DeepMemberHandle tail;
-	tail.insert(tail.end(), handle.begin() + 1, handle.end());
-	return deepMemberGroup[handle.front() - 1][members[handle.front() - 1].second->getDeepMemberIndex(tail)];
-}
-
-uint32_t StructType::getDeepMemberIndex(const DeepMemberHandle& handle) const
-{
-	if (handle.empty())
-		return 0;
-	return getDeepMemberGroup(handle) + 1;
-}
-
-uint32_t StructType::getDeepMemberGroup(const DeepMemberHandle& handle, const uint32_t endGroupNumber) const
-{
-	if (handle.empty())
-		return endGroupNumber;
-	DeepMemberHandle tail;
-	tail.insert(tail.end(), handle.begin() + 1, handle.end());
-	return deepMemberGroup[handle.front() - 1][members[handle.front() - 1].second->getDeepMemberIndex(tail, endGroupNumber)];
-}
-
-uint32_t StructType::getDeepMemberIndex(const DeepMemberHandle& handle, const uint32_t endGroupNumber) const
-{
-	return getDeepMemberGroup(handle, endGroupNumber) + 1;
-}
-
 void StructType::preprocessMemberEqualities()
 {
-	vec<vec<vec<pair<uint32_t, uint32_t>>>> neighbors;
+	// the deep members of the members are numbered consecutively, member by member with the member itself first
+	vec<uint32_t> memberStarts;
+	uint32_t deepMemberCount = 0;
 	for (uint32_t mi = 0; mi < getMemberCount(); mi++)
 	{
-		neighbors.push_back(vec<vec<pair<uint32_t, uint32_t>>>(members[mi].second->deepMemberGroups.size() + 1));
+		memberStarts.push_back(deepMemberCount);
+		deepMemberCount += members[mi].second->deepMemberGroups.size() + 1;
 	}
+	UnionFind equal(deepMemberCount);
 	for (const auto& eq : memberEqualities)
 	{
 		const uint32_t member0 = eq.first.front() - 1;
-		DeepMemberHandle tail0;
-		tail0.insert(tail0.end(), eq.first.begin() + 1, eq.first.end());
-		const uint32_t dMember0Index = members[member0].second->getDeepMemberIndex(tail0);
-		const pair<uint32_t, uint32_t> pr0{ member0, dMember0Index };
+		const StructType* const mType0 = members[member0].second;
+		const uint32_t node0 = mType0->getPathNode(eq.first.data() + 1, eq.first.size() - 1);
 
-		StructType* const tp = tail0.empty() ? members[member0].second : members[member0].second->deepMemberType[dMember0Index - 1];
+		const StructType* const tp = mType0->pathNodes[node0].type;
 
 		const uint32_t member1 = eq.second.front() - 1;
-		DeepMemberHandle tail1;
-		tail1.insert(tail1.end(), eq.second.begin() + 1, eq.second.end());
-		const uint32_t dMember1Index = members[member1].second->getDeepMemberIndex(tail1);
-		const pair<uint32_t, uint32_t> pr1{ member1, dMember1Index };
+		const StructType* const mType1 = members[member1].second;
+		const uint32_t node1 = mType1->getPathNode(eq.second.data() + 1, eq.second.size() - 1);
 
-		neighbors[member0][dMember0Index].push_back(pr1);
-		neighbors[member1][dMember1Index].push_back(pr0);
-
-		for (uint32_t i = 0; i < tp->deepMemberGroups.size(); i++)
-		{
-			const uint32_t ind0 = members[member0].second->getDeepMemberIndex(tail0, i);
-			const uint32_t ind1 = members[member1].second->getDeepMemberIndex(tail1, i);
-
-			neighbors[member0][ind0].push_back({ member1, ind1 });
-			neighbors[member1][ind1].push_back({ member0, ind0 });
-		}
+		// the members are equal together with all their deep members
+		for (uint32_t i = 0; i <= tp->deepMemberGroups.size(); i++)
+			equal.unite(memberStarts[member0] + mType0->getPathMemberIndex(node0, i), memberStarts[member1] + mType1->getPathMemberIndex(node1, i));
 	}
 
-	deepMemberGroup.reserve(getMemberCount());
+	// the groups are numbered in the order of their first deep members
 	constexpr uint32_t notset = std::numeric_limits<uint32_t>::max();
+	vec<uint32_t> rootGroup(deepMemberCount, notset);
+	deepMemberGroup.reserve(getMemberCount());
 	for (uint32_t mi = 0; mi < getMemberCount(); mi++)
 	{
-		deepMemberGroup.push_back(vec<uint32_t>(members[mi].second->deepMemberGroups.size() + 1, notset));
-	}
-	const auto bfs = [&](const uint32_t mi, const uint32_t dm, const auto& bfs_fun) -> void
-	{
-		deepMemberGroups.back().push_back({ mi, dm });
-		deepMemberGroup[mi][dm] = deepMemberGroups.size() - 1;
-		for (const pair<uint32_t, uint32_t>& nei : neighbors[mi][dm])
-			if (deepMemberGroup[nei.first][nei.second] == notset)
-				bfs_fun(nei.first, nei.second, bfs_fun);
-	};
-	for (uint32_t mi = 0; mi < getMemberCount(); mi++)
-	{
+		deepMemberGroup.push_back(vec<uint32_t>(members[mi].second->deepMemberGroups.size() + 1));
 		for (uint32_t dm = 0; dm <= members[mi].second->deepMemberGroups.size(); dm++)
 		{
-			if (deepMemberGroup[mi][dm] == notset)
+			uint32_t& group = rootGroup[equal.find(memberStarts[mi] + dm)];
+			if (group == notset)
 			{
+				group = deepMemberGroups.size();
 				deepMemberGroups.push_back({});
 				deepMemberType.push_back(dm == 0 ? members[mi].second : members[mi].second->deepMemberType[dm - 1]);
-				bfs(mi, dm, bfs);
 			}
+			deepMemberGroups[group].push_back({ mi, dm });
+			deepMemberGroup[mi][dm] = group;
 		}
 	}
 }
 
 uint32_t StructType::getDeepPropertyIndex(const DeepPropertyHandle& handle) const
 {
-	const DeepMemberHandle& path = handle.memberPath;
-	if (path.empty())
-		return deepPropertyGroup[0][handle.pHandle - 1];
-	//const uint32_t memberIndex = getDeepMemberIndex(path);
-	DeepMemberHandle pathTail;
-	pathTail.insert(pathTail.end(), path.begin() + 1, path.end());
-	return deepPropertyGroup[path.front()][members[path.front() - 1].second->getDeepPropertyIndex(DeepPropertyHandle(pathTail, handle.pHandle))];
-}
-
-uint32_t StructType::getDeepPropertyIndex(const DeepMemberHandle& handle, const uint32_t propertyIndex) const
-{
-	if (handle.empty())
-		return propertyIndex;
-	//const uint32_t memberIndex = getDeepMemberIndex(handle);
-	DeepMemberHandle pathTail;
-	pathTail.insert(pathTail.end(), handle.begin() + 1, handle.end());
-	return deepPropertyGroup[handle.front()][members[handle.front() - 1].second->getDeepPropertyIndex(pathTail, propertyIndex)];
+	const uint32_t node = getPathNode(handle.memberPath.data(), handle.memberPath.size());
+	return getPathPropertyIndex(node, pathNodes[node].type->deepPropertyGroup[0][handle.pHandle - 1]);
 }
 
 void StructType::preprocessPropertyEqualities()
 {
-	vec<vec<vec<pair<uint32_t, uint32_t>>>> neighbors;
-	neighbors.push_back(vec<vec<pair<uint32_t, uint32_t>>>(getPropertyCount()));
+	// the own properties are numbered first, then the flat properties of the members, member by member
+	vec<uint32_t> starts{ 0 };
+	uint32_t deepPropertyCount = getPropertyCount();
 	for (const auto& mem : members)
-		neighbors.push_back(vec<vec<pair<uint32_t, uint32_t>>>(mem.second->deepPropertyGroups.size()));
+	{
+		starts.push_back(deepPropertyCount);
+		deepPropertyCount += mem.second->deepPropertyGroups.size();
+	}
+	UnionFind equal(deepPropertyCount);
 	for (const auto& eq : propertyEqualities)
 	{
-		const auto& toIndPair = [&](const DeepPropertyHandle& handle) -> pair<uint32_t, uint32_t>
+		const auto& toIndex = [&](const DeepPropertyHandle& handle) -> uint32_t
 		{
 			if (handle.memberPath.empty())
-				return { 0, handle.pHandle - 1 };
-			const uint32_t memInd = handle.memberPath.front();//getDeepMemberIndex(handle.memberPath);
-			DeepMemberHandle pathTail;
-			pathTail.insert(pathTail.end(), handle.memberPath.begin() + 1, handle.memberPath.end());
-			return { memInd, members[handle.memberPath.front() - 1].second->getDeepPropertyIndex(DeepPropertyHandle(pathTail, handle.pHandle)) };
+				return handle.pHandle - 1;
+			const StructType* const mType = members[handle.memberPath.front() - 1].second;
+			const uint32_t node = mType->getPathNode(handle.memberPath.data() + 1, handle.memberPath.size() - 1);
+			return starts[handle.memberPath.front()] + mType->getPathPropertyIndex(node, mType->pathNodes[node].type->deepPropertyGroup[0][handle.pHandle - 1]);
 		};
-		const pair<uint32_t, uint32_t> p0 = toIndPair(eq.first);
-		const pair<uint32_t, uint32_t> p1 = toIndPair(eq.second);
-		neighbors[p0.first][p0.second].push_back(p1);
-		neighbors[p1.first][p1.second].push_back(p0);
+		equal.unite(toIndex(eq.first), toIndex(eq.second));
 	}
 	for (const auto& eq : memberEqualities)
 	{
 		const StructType* eqType = getDeepMemberType(eq.first);
+		const StructType* const mType0 = members[eq.first.front() - 1].second;
+		const StructType* const mType1 = members[eq.second.front() - 1].second;
+		const uint32_t node0 = mType0->getPathNode(eq.first.data() + 1, eq.first.size() - 1);
+		const uint32_t node1 = mType1->getPathNode(eq.second.data() + 1, eq.second.size() - 1);
 		for (uint32_t pi = 0; pi < eqType->deepPropertyGroups.size(); pi++)
+			equal.unite(starts[eq.first.front()] + mType0->getPathPropertyIndex(node0, pi), starts[eq.second.front()] + mType1->getPathPropertyIndex(node1, pi));
+	}
+
+	// the groups are numbered in the order of their first properties
+	constexpr uint32_t notset = std::numeric_limits<uint32_t>::max();
+	vec<uint32_t> rootGroup(deepPropertyCount, notset);
+	deepPropertyGroup.reserve(getMemberCount() + 1);
+	deepPropertyGroup.push_back(vec<uint32_t>(getPropertyCount()));
+	for (const auto& mem : members)
+		deepPropertyGroup.push_back(vec<uint32_t>(mem.second->deepPropertyGroups.size()));
+	for (uint32_t mi = 0; mi < deepPropertyGroup.size(); mi++)
+	{
+		for (uint32_t pi = 0; pi < deepPropertyGroup[mi].size(); pi++)
 		{
-			const auto& toIndPair = [&](const DeepMemberHandle& handle) -> pair<uint32_t, uint32_t>
+			uint32_t& group = rootGroup[equal.find(starts[mi] + pi)];
+			if (group == notset)
 			{
-				DeepMemberHandle tail;
-				tail.insert(tail.end(), handle.begin() + 1, handle.end());
-				return { handle.front(), members[handle.front() - 1].second->getDeepPropertyIndex(tail, pi) };
-			};
-			const pair<uint32_t, uint32_t> p0 = toIndPair(eq.first);
-			const pair<uint32_t, uint32_t> p1 = toIndPair(eq.second);
-			neighbors[p0.first][p0.second].push_back(p1);
-			neighbors[p1.first][p1.second].push_back(p0);
+				group = deepPropertyGroups.size();
+				deepPropertyGroups.push_back({});
+			}
+			deepPropertyGroups[group].push_back({ mi, pi });
+			deepPropertyGroup[mi][pi] = group;
 		}
 	}
+}
 
-	deepPropertyGroup.reserve(getMemberCount() + 1);
-	constexpr uint32_t notset = std::numeric_limits<uint32_t>::max();
-	deepPropertyGroup.push_back(vec<uint32_t>(getPropertyCount(), notset));
-	for (const auto& mem : members)
-		deepPropertyGroup.push_back(vec<uint32_t>(mem.second->deepPropertyGroups.size(), notset));
-	const auto& bfs = [&](const uint32_t mi, const uint32_t pi, const auto& bfs_fun) -> void
-	{
-		deepPropertyGroups.back().push_back({ mi, pi });
-		deepPropertyGroup[mi][pi] = deepPropertyGroups.size() - 1;
-		for (const pair<uint32_t, uint32_t>& nei : neighbors[mi][pi])
-			if (deepPropertyGroup[nei.first][nei.second] == notset)
-				bfs_fun(nei.first, nei.second, bfs_fun);
-	};
-	for (uint32_t pi = 0; pi < getPropertyCount(); pi++)
+void StructType::buildPathNodes()
+{
+	pathNodes.push_back({ this, 1, 0, 0 });
+	for (uint32_t pi = 0; pi < deepPropertyGroups.size(); pi++)
+		pathPropertyIndices.push_back(pi);
+	for (uint32_t dm = 0; dm <= deepMemberGroups.size(); dm++)
+		pathMemberIndices.push_back(dm);
+	// the roots of the members' tries are the children of the root, the rest of every trie follows in its order
+	pathNodes.resize(getMemberCount() + 1);
+	for (MemberHandle mh = 1; mh <= getMemberCount(); mh++)
 	{
-		if (deepPropertyGroup[0][pi] == notset)
+		const StructType* const mType = members[mh - 1].second;
+		const uint32_t offset = pathNodes.size() - 1;
+		for (uint32_t mn = 0; mn < mType->pathNodes.size(); mn++)
 		{
-			deepPropertyGroups.push_back({});
-			bfs(0, pi, bfs);
+			const PathNode& memberNode = mType->pathNodes[mn];
+			PathNode node{ memberNode.type, offset + memberNode.firstChild, uint32_t(pathPropertyIndices.size()), uint32_t(pathMemberIndices.size()) };
+			for (uint32_t pi = 0; pi < memberNode.type->deepPropertyGroups.size(); pi++)
+				pathPropertyIndices.push_back(deepPropertyGroup[mh][mType->pathPropertyIndices[memberNode.propertyStart + pi]]);
+			for (uint32_t dm = 0; dm <= memberNode.type->deepMemberGroups.size(); dm++)
+				pathMemberIndices.push_back(deepMemberGroup[mh - 1][mType->pathMemberIndices[memberNode.memberStart + dm]] + 1);
+			if (mn == 0)
+				pathNodes[mh] = node;
+			else
+				pathNodes.push_back(node);
 		}
 	}
-	for (uint32_t mim = 0; mim < getMemberCount(); mim++)
+}
+
+void StructType::preprocessExamples()
+{
+	for (Example& example : examples)
 	{
-		for (uint32_t pi = 0; pi < members[mim].second->deepPropertyGroups.size(); pi++)
+		example.assignment = PartialAssignment(getDeepPropertyDistinctCount());
+		example.contradiction = example.properties.size();
+		for (uint32_t pi = 0; pi < example.properties.size(); pi++)
 		{
-			if (deepPropertyGroup[mim + 1][pi] == notset)
-			{
-				deepPropertyGroups.push_back({});
-				bfs(mim + 1, pi, bfs);
-			}
+			const uint32_t index = getDeepPropertyIndex(example.properties[pi].handle);
+			const bool value = !example.properties[pi].negated;
+			if (!example.assignment.allows(index, value) && example.contradiction == example.properties.size())
+				example.contradiction = pi;
+			example.assignment.set(index, value);
 		}
 	}
 }
@@ -423,15 +599,15 @@ void StructType::checkPromotions(ErrorReporter& er) const
 		const MemberHandle mh = promotion.second->getMember(name);
 		if (!mh)
 		{
-			er.reportProc("Type " + name + " promotes to type " + promotion.second->name + ", which does not have member with the name " + name + ".");
+			er.reportProc("Type " + getName() + " promotes to type " + promotion.second->getName() + ", which does not have member with the name " + getName() + ".");
 			continue;
 		}
 		if (promotion.second->getMemberType(mh) != this)
-			er.reportProc("Type " + name + " promotes to type " + promotion.second->name + ", whose member " + name + " is of type " + promotion.second->getMemberType(mh)->name + " instead of " + name + ".");
+			er.reportProc("Type " + getName() + " promotes to type " + promotion.second->getName() + ", whose member " + getName() + " is of type " + promotion.second->getMemberType(mh)->getName() + " instead of " + getName() + ".");
 	}
 }
 
-void StructType::preprocessChildPromotions()
+void StructType::preprocessChildPromotions(vec<vec<FlatProperty>>& flat)
 {
 	for (const auto& m : members)
 	{
@@ -441,54 +617,92 @@ void StructType::preprocessChildPromotions()
 			{
 				const MemberHandle mh = getMember(m.second->name);
 				const uint32_t flatPropertyIndex = deepPropertyGroup[mh][m.second->getDeepPropertyIndex(promotion.first)];
-				flatRelations.push_back({ FlatProperty(flatPropertyIndex, false) });
+				flat.push_back({ FlatProperty(flatPropertyIndex, false) });
 			}
 		}
+		// the promoted type is preprocessed before this one, so its promotions to this type only get their maps now
+		for (Promotion& promotion : m.second->promotions)
+		{
+			if (promotion.target == this)
+				promotion.propertyMap = deepPropertyGroup[getMember(m.second->name)];
+		}
 	}
 }
 
 void StructType::preprocessOwnPromotions()
 {
 	promotions.reserve(rawPromotions.size());
-	for (const pair<DeepPropertyHandle, const StructType*> promotion : rawPromotions)
-		promotions.push_back({ getDeepPropertyIndex(promotion.first), promotion.second });
+	for (const pair<DeepPropertyHandle, const StructType*>& promotion : rawPromotions)
+		promotions.push_back({ getDeepPropertyIndex(promotion.first), promotion.second, {} });
 }
 
-void StructType::preprocessRelations()
+void StructType::flattenRelation(const vec<DeepProperty>& relation, vec<vec<FlatProperty>>& flat) const
 {
-	for (const vec<DeepProperty>& relation : relations)
+	// member equalities are replaced by the equalities of all their (distinct) properties,
+	// so the relation is expanded into the product of the property-equality clauses
+	vec<vec<FlatProperty>> expanded(1);
+	for (const DeepProperty& property : relation)
 	{
-		vec<FlatProperty> newRelation(relation.size());
-		for (uint32_t i = 0; i < relation.size(); i++)
+		if (property.handle.pHandle)
 		{
-			newRelation[i].index = getDeepPropertyIndex(relation[i].handle);
-			newRelation[i].negated = relation[i].negated;
+			for (vec<FlatProperty>& partial : expanded)
+				partial.push_back(FlatProperty(getDeepPropertyIndex(property.handle), property.negated));
+			continue;
+		}
+		// a negated member equality is not expressible as a small set of clauses
+		assert(!property.negated);
+		const StructType* const eqType = getDeepMemberType(property.memberHandle0);
+		vec<vec<FlatProperty>> product;
+		product.reserve(expanded.size() * eqType->deepPropertyGroups.size() * 2);
+		const uint32_t node0 = getPathNode(property.memberHandle0.data(), property.memberHandle0.size());
+		const uint32_t node1 = getPathNode(property.memberHandle1.data(), property.memberHandle1.size());
+		for (uint32_t pi = 0; pi < eqType->deepPropertyGroups.size(); pi++)
+		{
+			const uint32_t index0 = getPathPropertyIndex(node0, pi);
+			const uint32_t index1 = getPathPropertyIndex(node1, pi);
+			if (index0 == index1)
+				continue;
+			for (const vec<FlatProperty>& partial : expanded)
+			{
+				product.push_back(partial);
+				product.back().push_back(FlatProperty(index0, true));
+				product.back().push_back(FlatProperty(index1, false));
+				product.push_back(partial);
+				product.back().push_back(FlatProperty(index0, false));
+				product.back().push_back(FlatProperty(index1, true));
+			}
 		}
-		flatRelations.push_back(newRelation);
+		expanded = product;
 	}
+	flat.insert(flat.end(), expanded.begin(), expanded.end());
+}
+
+void StructType::preprocessRelations(vec<vec<FlatProperty>>& flat)
+{
+	for (const vec<DeepProperty>& relation : relations)
+		flattenRelation(relation, flat);
 	for (uint32_t i = 0; i < getMemberCount(); i++)
 	{
-		for (const vec<FlatProperty>& memberRelation : members[i].second->flatRelations)
+		const ClauseArena& memberRelations = members[i].second->flatRelations;
+		for (uint32_t clause = 0; clause < memberRelations.getClauseCount(); clause++)
 		{
-			vec<FlatProperty> substRelation(memberRelation.size());
-			for (uint32_t j = 0; j < memberRelation.size(); j++)
-			{
-				substRelation[j].index = deepPropertyGroup[i + 1][memberRelation[j].index];
-				substRelation[j].negated = memberRelation[j].negated;
-			}
-			flatRelations.push_back(substRelation);
+			vec<FlatProperty> substRelation;
+			substRelation.reserve(memberRelations[clause].size());
+			for (const uint32_t literal : memberRelations[clause])
+				substRelation.push_back(FlatProperty(deepPropertyGroup[i + 1][literal >> 1], literal & 1));
+			flat.push_back(substRelation);
 		}
 	}
-	if (flatRelations.empty())
+	if (flat.empty())
 		return;
-	for (vec<FlatProperty>& relation : flatRelations)
+	for (vec<FlatProperty>& relation : flat)
 	{
 		sort(relation.begin(), relation.end(), [](const FlatProperty lhs, const FlatProperty rhs)
 		{
 			return lhs.index < rhs.index || (lhs.index == rhs.index && !lhs.negated && rhs.negated);
 		});
 	}
-	sort(flatRelations.begin(), flatRelations.end(), [](const vec<FlatProperty>& lhs, const vec<FlatProperty>& rhs)
+	sort(flat.begin(), flat.end(), [](const vec<FlatProperty>& lhs, const vec<FlatProperty>& rhs)
 	{
 		if (lhs.size() < rhs.size())
 			return true;
@@ -503,14 +717,24 @@ void StructType::preprocessRelations()
 		}
 		return false;
 	});
-	vec<vec<FlatProperty>> filtered;
-	filtered.push_back(flatRelations.front());
-	for (uint32_t i = 1; i < flatRelations.size(); i++)
+	flat.erase(std::unique(flat.begin(), flat.end()), flat.end());
+}
+
+void StructType::simplifyRelations(vec<vec<FlatProperty>>& flat, const SimplificationOptions& options)
+{
+	ClauseSimplifier simplifier(getDeepPropertyDistinctCount(), options);
+	flat = simplifier.simplify(flat);
+	simplificationStats = simplifier.getStats();
+	size_t literalCount = 0;
+	for (const vec<FlatProperty>& relation : flat)
+		literalCount += relation.size();
+	flatRelations.reserve(flat.size(), literalCount);
+	for (const vec<FlatProperty>& relation : flat)
 	{
-		if (flatRelations[i] != flatRelations[i - 1])
-			filtered.push_back(flatRelations[i]);
+		for (const FlatProperty& property : relation)
+			flatRelations.addLiteral(property.index << 1 | property.negated);
+		flatRelations.endClause();
 	}
-	flatRelations = filtered;
 }
 
 bool StructType::checkDeepPropertyValid(const DeepPropertyHandle& handle)
@@ -519,82 +743,306 @@ bool StructType::checkDeepPropertyValid(const DeepPropertyHandle& handle)
 	return parentType && handle.pHandle <= parentType->properties.size();
 }
 
-size_t StructType::getPossibleInstancesCount(vec<bool> specified, vec<bool> values) const
+void StructType::writeSnapshot(SnapshotWriter& writer, const umap<const StructType*, uint32_t>& typeIndices) const
 {
-	for (const pair<uint32_t, const StructType*> promotion : promotions)
+	assert(preprocessed);
+	const auto& writeDeepProperty = [&writer](const DeepProperty& property)
 	{
-		if (specified[promotion.first])
-			continue;
-		vec<bool> promotedSpecified(promotion.second->deepPropertyGroups.size(), false);
-		vec<bool> promotedValues(promotion.second->deepPropertyGroups.size());
-		const uint32_t promotedMemberIndex = promotion.second->deepMemberGroup[0][promotion.second->getMember(name) - 1];
-		for (uint32_t i = 0; i < specified.size(); i++)
+		writer.writeWords(property.handle.memberPath);
+		writer.writeWord(property.handle.pHandle);
+		writer.writeWords(property.memberHandle0);
+		writer.writeWords(property.memberHandle1);
+		writer.writeWord(property.negated);
+	};
+
+	writer.writeWord(properties.size());
+	for (const Symbol property : properties)
+		writer.writeString(symbols->getName(property));
+	writer.writeWord(members.size());
+	for (const pair<Symbol, StructType*>& member : members)
+	{
+		writer.writeString(symbols->getName(member.first));
+		writer.writeWord(typeIndices.at(member.second));
+	}
+	writer.writeWord(rawPromotions.size());
+	for (const pair<DeepPropertyHandle, const StructType*>& promotion : rawPromotions)
+	{
+		writer.writeWords(promotion.first.memberPath);
+		writer.writeWord(promotion.first.pHandle);
+		writer.writeWord(typeIndices.at(promotion.second));
+	}
+	writer.writeWord(promotions.size());
+	for (const Promotion& promotion : promotions)
+	{
+		writer.writeWord(promotion.property);
+		writer.writeWord(typeIndices.at(promotion.target));
+		writer.writeWords(promotion.propertyMap);
+	}
+
+	writer.writeWordLists(deepMemberGroup);
+	writer.writePairLists(deepMemberGroups);
+	writer.writeWord(deepMemberType.size());
+	for (const StructType* type : deepMemberType)
+		writer.writeWord(typeIndices.at(type));
+	writer.writeWordLists(deepPropertyGroup);
+	writer.writePairLists(deepPropertyGroups);
+	writer.writeWord(pathNodes.size());
+	for (const PathNode& node : pathNodes)
+	{
+		writer.writeWord(typeIndices.at(node.type));
+		writer.writeWord(node.firstChild);
+		writer.writeWord(node.propertyStart);
+		writer.writeWord(node.memberStart);
+	}
+	writer.writeWords(pathPropertyIndices);
+	writer.writeWords(pathMemberIndices);
+
+	writer.writeWords(flatRelations.getStarts(), flatRelations.getClauseCount() + 1);
+	writer.writeWords(flatRelations.getLiterals(), flatRelations.getLiteralCount());
+
+	writer.writeWord(examples.size());
+	for (const Example& example : examples)
+	{
+		writer.writeString(example.name);
+		writer.writeString(example.description);
+		writer.writeWord(example.lineNumber);
+		writer.writeWord(example.properties.size());
+		for (const DeepProperty& property : example.properties)
+			writeDeepProperty(property);
+		vec<uint32_t> literals;
+		for (uint32_t variable = 0; variable < example.assignment.getVariableCount(); variable++)
 		{
-			if (specified[i])
-			{
-				const uint32_t promotedIndex = promotion.second->deepPropertyGroup[promotedMemberIndex][i];
-				promotedSpecified[promotedIndex] = true;
-				promotedValues[promotedIndex] = values[i];
-			}
+			if (example.assignment.isSpecified(variable))
+				literals.push_back(variable << 1 | !example.assignment.getValue(variable));
+		}
+		writer.writeWord(example.assignment.getVariableCount());
+		writer.writeWords(literals);
+		writer.writeWord(example.contradiction);
+	}
+
+	writer.writeWide(deepPropertyFullCount);
+	writer.writeWide(deepMemberFullCount);
+	for (const size_t value : { simplificationStats.clausesBefore, simplificationStats.literalsBefore, simplificationStats.clausesAfter,
+		simplificationStats.literalsAfter, simplificationStats.subsumedClauses, simplificationStats.strengthenedClauses,
+		simplificationStats.failedLiterals, simplificationStats.substitutedVariables, simplificationStats.eliminatedVariables })
+		writer.writeWide(value);
+}
+
+bool StructType::readSnapshot(SnapshotReader& reader, const vec<StructType*>& types)
+{
+	assert(!preprocessed && properties.empty() && members.empty());
+	const auto& readType = [&reader, &types]() -> StructType*
+	{
+		const uint32_t index = reader.readWord();
+		if (index < types.size())
+			return types[index];
+		reader.invalidate();
+		return nullptr;
+	};
+	const auto& readDeepProperty = [&reader]()
+	{
+		DeepProperty property;
+		property.handle.memberPath = reader.readWords();
+		property.handle.pHandle = reader.readWord();
+		property.memberHandle0 = reader.readWords();
+		property.memberHandle1 = reader.readWords();
+		property.negated = reader.readWord();
+		return property;
+	};
+
+	for (uint32_t pi = reader.readLength(1); pi > 0 && reader.isValid(); pi--)
+	{
+		const Symbol propertyName = symbols->intern(reader.readString());
+		if (isNameUsed(propertyName))
+			reader.invalidate();
+		else
+			addProperty(propertyName);
+	}
+	for (uint32_t mi = reader.readLength(2); mi > 0 && reader.isValid(); mi--)
+	{
+		const Symbol memberName = symbols->intern(reader.readString());
+		StructType* const memberType = readType();
+		if (!memberType || isNameUsed(memberName))
+			reader.invalidate();
+		else
+			addMember(memberName, memberType);
+	}
+	rawPromotions.resize(reader.readLength(3));
+	for (pair<DeepPropertyHandle, const StructType*>& promotion : rawPromotions)
+	{
+		promotion.first.memberPath = reader.readWords();
+		promotion.first.pHandle = reader.readWord();
+		promotion.second = readType();
+	}
+	promotions.resize(reader.readLength(3));
+	for (Promotion& promotion : promotions)
+	{
+		promotion.property = reader.readWord();
+		promotion.target = readType();
+		promotion.propertyMap = reader.readWords();
+	}
+
+	// every index read is checked against the table of the type it points into, the tables of the other types by checkSnapshot
+	const auto& check = [&reader](const bool condition)
+	{
+		if (!condition)
+			reader.invalidate();
+	};
+	deepMemberGroup = reader.readWordLists();
+	deepMemberGroups = reader.readPairLists();
+	deepMemberType.resize(reader.readLength(1));
+	for (StructType*& type : deepMemberType)
+		type = readType();
+	check(deepMemberGroup.size() == getMemberCount() && deepMemberType.size() == deepMemberGroups.size());
+	for (const vec<uint32_t>& memberGroups : deepMemberGroup)
+	{
+		for (const uint32_t group : memberGroups)
+			check(group < deepMemberGroups.size());
+	}
+	for (const vec<pair<uint32_t, uint32_t>>& group : deepMemberGroups)
+	{
+		for (const pair<uint32_t, uint32_t>& deepMember : group)
+			check(deepMember.first < deepMemberGroup.size() && deepMember.second < deepMemberGroup[deepMember.first].size());
+	}
+	deepPropertyGroup = reader.readWordLists();
+	deepPropertyGroups = reader.readPairLists();
+	check(deepPropertyGroup.size() == getMemberCount() + 1 && deepPropertyGroup.front().size() == getPropertyCount());
+	for (const vec<uint32_t>& memberGroups : deepPropertyGroup)
+	{
+		for (const uint32_t group : memberGroups)
+			check(group < deepPropertyGroups.size());
+	}
+	for (const vec<pair<uint32_t, uint32_t>>& group : deepPropertyGroups)
+	{
+		for (const pair<uint32_t, uint32_t>& deepProperty : group)
+			check(deepProperty.first < deepPropertyGroup.size() && deepProperty.second < deepPropertyGroup[deepProperty.first].size());
+	}
+	for (const Promotion& promotion : promotions)
+		check(promotion.property < deepPropertyGroups.size() && promotion.propertyMap.size() == deepPropertyGroups.size());
+
+	pathNodes.resize(reader.readLength(4));
+	for (PathNode& node : pathNodes)
+	{
+		node.type = readType();
+		node.firstChild = reader.readWord();
+		node.propertyStart = reader.readWord();
+		node.memberStart = reader.readWord();
+	}
+	pathPropertyIndices = reader.readWords();
+	pathMemberIndices = reader.readWords();
+	check(!pathNodes.empty() && pathNodes.front().type == this);
+	for (const uint32_t index : pathPropertyIndices)
+		check(index < deepPropertyGroups.size());
+	for (const uint32_t index : pathMemberIndices)
+		check(index <= deepMemberGroups.size());
+
+	// the relations are used in place if the words can be, so that they stay in the shared pages of a mapped file
+	uint32_t startCount = 0;
+	uint32_t literalCount = 0;
+	const uint32_t* starts = reader.viewWords(startCount);
+	const uint32_t* literals = starts ? reader.viewWords(literalCount) : nullptr;
+	vec<uint32_t> readStarts;
+	vec<uint32_t> readLiterals;
+	if (!literals)
+	{
+		readStarts = reader.readWords();
+		readLiterals = reader.readWords();
+		starts = readStarts.data();
+		startCount = readStarts.size();
+		literals = readLiterals.data();
+		literalCount = readLiterals.size();
+	}
+	check(startCount > 0 && starts[0] == 0 && starts[startCount - 1] == literalCount && std::is_sorted(starts, starts + startCount));
+	for (uint32_t li = 0; li < literalCount && reader.isValid(); li++)
+		check((literals[li] >> 1) < deepPropertyGroups.size());
+	if (!reader.isValid())
+		flatRelations.clear();
+	else if (readStarts.empty())
+		flatRelations.view(starts, startCount - 1, literals);
+	else
+	{
+		flatRelations.reserve(startCount - 1, literalCount);
+		for (uint32_t si = 1; si < startCount; si++)
+		{
+			for (uint32_t li = starts[si - 1]; li < starts[si]; li++)
+				flatRelations.addLiteral(literals[li]);
+			flatRelations.endClause();
 		}
-		const size_t promotedTypeCount = promotion.second->getPossibleInstancesCount(promotedSpecified, promotedValues);
-		specified[promotion.first] = true;
-		values[promotion.first] = false;
-		const size_t currentTypeCount = getPossibleInstancesCount(specified, values);
-		specified[promotion.first] = false;
-		return promotedTypeCount + currentTypeCount;
-	}
-	bool changed;
-	do
-	{
-		changed = false;
-		for (const vec<FlatProperty>& relation : flatRelations)
+	}
+
+	examples.resize(reader.readLength(6));
+	for (Example& example : examples)
+	{
+		example.name = reader.readString();
+		example.description = reader.readString();
+		example.lineNumber = reader.readWord();
+		example.properties.resize(reader.readLength(5));
+		for (DeepProperty& property : example.properties)
+			property = readDeepProperty();
+		example.assignment = PartialAssignment(reader.readWord());
+		check(example.assignment.getVariableCount() == deepPropertyGroups.size());
+		for (const uint32_t literal : reader.readWords())
 		{
-			int32_t unspecInd = -1;
-			bool useless = false;
-			for (uint32_t i = 0; i < relation.size(); i++)
-			{
-				const uint32_t ind = relation[i].index;
-				if (specified[ind])
-				{
-					if (values[ind] != relation[i].negated)
-					{
-						useless = true;
-						break;
-					}
-				}
-				else
-				{
-					if (unspecInd == -1)
-						unspecInd = i;
-					else
-						unspecInd = -2;
-				}
-			}
-			if (!useless && unspecInd == -1)
-				return 0;
-			if (!useless && unspecInd != -2)
-			{
-				specified[relation[unspecInd].index] = true;\
-				values[relation[unspecInd].index] = !relation[unspecInd].negated;
-				changed = true;
-			}
+			if ((literal >> 1) < example.assignment.getVariableCount())
+				example.assignment.set(literal >> 1, !(literal & 1));
+			else
+				reader.invalidate();
+		}
+		example.contradiction = reader.readWord();
+		check(example.contradiction <= example.properties.size());
+	}
+
+	deepPropertyFullCount = reader.readWide();
+	deepMemberFullCount = reader.readWide();
+	for (size_t* const value : { &simplificationStats.clausesBefore, &simplificationStats.literalsBefore, &simplificationStats.clausesAfter,
+		&simplificationStats.literalsAfter, &simplificationStats.subsumedClauses, &simplificationStats.strengthenedClauses,
+		&simplificationStats.failedLiterals, &simplificationStats.substitutedVariables, &simplificationStats.eliminatedVariables })
+		*value = reader.readWide();
+
+	preprocessed = reader.isValid();
+	return preprocessed;
+}
+
+bool StructType::checkSnapshot() const
+{
+	for (uint32_t mi = 0; mi < getMemberCount(); mi++)
+	{
+		const StructType* const mType = members[mi].second;
+		if (deepMemberGroup[mi].size() != mType->deepMemberGroups.size() + 1 || deepPropertyGroup[mi + 1].size() != mType->deepPropertyGroups.size())
+			return false;
+	}
+	// the children of a node and its ranges of the index maps are sized by the type of the node
+	for (const PathNode& node : pathNodes)
+	{
+		if (size_t(node.firstChild) + node.type->getMemberCount() > pathNodes.size()
+			|| size_t(node.propertyStart) + node.type->deepPropertyGroups.size() > pathPropertyIndices.size()
+			|| size_t(node.memberStart) + node.type->deepMemberGroups.size() + 1 > pathMemberIndices.size())
+			return false;
+		for (MemberHandle mh = 1; mh <= node.type->getMemberCount(); mh++)
+		{
+			if (pathNodes[node.firstChild + mh - 1].type != node.type->getMemberType(mh))
+				return false;
+		}
+	}
+	for (const Promotion& promotion : promotions)
+	{
+		for (const uint32_t property : promotion.propertyMap)
+		{
+			if (property >= promotion.target->deepPropertyGroups.size())
+				return false;
 		}
-	} while (changed);
-	for (uint32_t i = 0; i < specified.size(); i++)
+	}
+	// the deep properties of the examples are resolved when their contradictions are reported
+	for (const Example& example : examples)
 	{
-		if (!specified[i])
+		for (const DeepProperty& property : example.properties)
 		{
-			specified[i] = true;
-			values[i] = false;
-			const size_t c0 = getPossibleInstancesCount(specified, values);
-			values[i] = true;
-			const size_t c1 = getPossibleInstancesCount(specified, values);
-			return c0 + c1;
+			const StructType* type = this;
+			for (const MemberHandle mh : property.handle.memberPath)
+				type = type && mh >= 1 && mh <= type->getMemberCount() ? type->getMemberType(mh) : nullptr;
+			if (!type || property.handle.pHandle == 0 || property.handle.pHandle > type->getPropertyCount())
+				return false;
 		}
 	}
-	/*cout << endl;
-	for (uint32_t i = 0; i < values.size(); i++)
-		cout << values[i] << " ";*/
-	return 1;
+	return true;
 }
\ No newline at end of file
@@ -1,7 +1,17 @@
 #pragma once
 
+#include <limits>
+#include <mutex>
+
+#include "clause-arena.hpp"
+#include "clause-simplifier.hpp"
+#include "implication-index.hpp"
+#include "instance-circuit.hpp"
 #include "parse-utils.hpp"
+#include "partial-assignment.hpp"
+#include "ptr.hpp"
 #include "str.hpp"
+#include "symbol-table.hpp"
 #include "umap.hpp"
 #include "vec.hpp"
 
@@ -21,15 +31,18 @@ struct hash<DeepMemberHandle>
 {
 	size_t operator()(const DeepMemberHandle& handle) const
 	{
-		size_t hsh = 9823453;
+		// the handles are small consecutive numbers, so every one is mixed in with the finalizer of splitmix64
+		uint64_t hsh = handle.size();
 		for (const MemberHandle& partial : handle)
 		{
-			hsh += partial + partial * hsh + 294587;
+			hsh = (hsh ^ partial) * 0x9e3779b97f4a7c15ull;
+			hsh = (hsh ^ (hsh >> 30)) * 0xbf58476d1ce4e5b9ull;
+			hsh = (hsh ^ (hsh >> 27)) * 0x94d049bb133111ebull;
+			hsh ^= hsh >> 31;
 		}
 		return hsh;
 	}
 };
-
 }
 
 struct DeepPropertyHandle
@@ -60,7 +73,7 @@ struct DeepProperty
 	DeepProperty(const DeepPropertyHandle& handle, const bool negated) : handle(handle), negated(negated)
 	{
 	}
-	DeepProperty(const DeepMemberHandle& memberHandle0, const DeepMemberHandle& memberHandle1) : handle(0), memberHandle0(memberHandle0), memberHandle1(memberHandle1)
+	DeepProperty(const DeepMemberHandle& memberHandle0, const DeepMemberHandle& memberHandle1) : handle(0), memberHandle0(memberHandle0), memberHandle1(memberHandle1), negated(false)
 	{
 	}
 };
@@ -83,31 +96,81 @@ struct FlatProperty
 
 typedef vec<vec<DeepProperty>> PropertyRelations;
 
+class InstanceCounter;
+class SnapshotReader;
+class SnapshotWriter;
+class StructType;
+
+// An example of a type stated in an example scope, i.e. the values of some of its deep properties.
+struct Example
+{
+	str name;
+	str description;
+	uint32_t lineNumber;
+	vec<DeepProperty> properties;
+	// the stated values over the flat properties, filled in when the type is preprocessed
+	PartialAssignment assignment;
+	// the first stated property whose flat property was already stated with the other value, or the number of the properties
+	uint32_t contradiction = 0;
+};
+
+struct Promotion
+{
+	// the flat index of the promoted property
+	uint32_t property;
+	const StructType* target;
+	// maps the flat properties of the promoted type to the flat properties of the target, filled in when the target is preprocessed
+	vec<uint32_t> propertyMap;
+
+	// maps the specified properties of the assignment to the properties of the target; returns false if two properties
+	// merged by the target are specified with different values
+	bool project(const PartialAssignment& assignment, PartialAssignment& projected) const;
+};
+
 class StructType
 {
+	friend class ApproximateCounter;
+	friend class ConsistencyOracle;
+	friend class ExampleValidator;
+	friend class ImplicationIndex;
+	friend class InstanceCircuit;
+	friend class InstanceCounter;
+	friend class InstanceEnumerator;
+
 public:
 	static constexpr PropertyHandle NoProperty = 0;
 	static constexpr MemberHandle NoMember = 0;
 
-	StructType(const str& name) : name(name)
-	{}
+	// the names are interned into the symbol table, which is shared by the types of a universe
+	StructType(Symbol name, SymbolTable& symbols);
+	// defined where the counter of the type is complete
+	StructType(StructType&& type);
+	StructType& operator=(StructType&& type);
+	~StructType();
 
-	str getName() const;
+	const str& getName() const;
+	Symbol getSymbol() const;
+	SymbolTable& getSymbols() const;
 
-	PropertyHandle addProperty(const str& name);
-	PropertyHandle getProperty(const str& name) const;
-	str getPropertyName(PropertyHandle handle) const;
+	PropertyHandle addProperty(Symbol name);
+	PropertyHandle getProperty(Symbol name) const;
+	const str& getPropertyName(PropertyHandle handle) const;
 	size_t getPropertyCount() const;
+	// the number of the deep properties counted with multiplicity, stored when the type is preprocessed
 	size_t getDeepPropertyFullCount() const;
 	size_t getDeepPropertyDistinctCount() const;
+	// the flat index of the deep property, the type must be preprocessed
+	uint32_t getDeepPropertyIndex(const DeepPropertyHandle& handle) const;
+	// the path to a representative of the flat property, e.g. "set.finite"
+	str getDeepPropertyName(uint32_t index) const;
 
-	MemberHandle addMember(const str& name, StructType* type);
-	MemberHandle getMember(const str& name) const;
-	const StructType* getMemberType(const str& name) const;
+	MemberHandle addMember(Symbol name, StructType* type);
+	MemberHandle getMember(Symbol name) const;
 	const StructType* getMemberType(MemberHandle handle) const;
 	const StructType* getDeepMemberType(const DeepMemberHandle& handle) const;
-	str getMemberName(MemberHandle handle) const;
+	const str& getMemberName(MemberHandle handle) const;
 	size_t getMemberCount() const;
+	// the number of the deep members counted with multiplicity, stored when the type is preprocessed
 	size_t getDeepMemberFullCount() const;
 	size_t getDeepMemberDistinctCount() const;
 
@@ -115,10 +178,17 @@ public:
 	void addPropertyEquality(const DeepPropertyHandle& p0, const DeepPropertyHandle& p1);
 	void addPropertyRelations(const PropertyRelations& newRelations);
 	void addPromotion(const DeepPropertyHandle& propertyHandle, const StructType* promoteTo);
+	void addExample(const Example& example);
+	const vec<Example>& getExamples() const;
 
-	bool isNameUsed(const str& name) const;
+	bool isNameUsed(Symbol name) const;
+	// whether the type has a member of the other type or a property that promotes to it
+	bool dependsOn(const StructType* type) const;
+	// drops everything added to the type and everything built from it, only the name is kept
+	void reset();
 
-	void preprocess();
+	// preprocesses the members first, the options apply to the simplification of all the types preprocessed
+	void preprocess(const SimplificationOptions& options = SimplificationOptions());
 	bool isPreprocessed() const;
 
 	// TODO: add a method for processing the added equalities and relations (to be called after the analysis of the sources)
@@ -127,19 +197,49 @@ public:
 	uint32_t getDeepMemberId(const DeepMemberHandle& handle) const;
 	//uint32_t getDeepMemberCount() const;
 	size_t getFlatRelationCount() const;
+	const SimplificationStats& getSimplificationStats() const;
 
+	// the count stored by storePossibleInstancesCount, or counted on every call if there is none
 	size_t getPossibleInstancesCount() const;
+	// counts the instances that satisfy the relations over the deep properties, e.g. parsed by parseAssumptions;
+	// a promoted property assumed true selects the instances of the type it promotes to
+	size_t getPossibleInstancesCount(const PropertyRelations& assumptions) const;
+	// estimates the count within the factor (1 + tolerance) with the given probability
+	double getApproximateInstancesCount(double tolerance, double confidence) const;
+
+	// compiles the relations into a circuit that answers the counting queries, the type must be preprocessed
+	void compile();
+	bool isCompiled() const;
+	// counts the instances once by the circuit, the type and its promotion targets must be compiled
+	void storePossibleInstancesCount();
+	const InstanceCircuit* getCircuit() const;
+	// builds the implication closure of the relations, the type and its promotion targets must be preprocessed
+	void buildImplicationIndex();
+	const ImplicationIndex* getImplicationIndex() const;
+	// the promoted deep properties with the types they promote to, the targets must be preprocessed as well
+	const vec<Promotion>& getPromotions() const;
 
 	void precheck(ErrorReporter& er) const;
 
+	// writes the preprocessed type with the other types referred to by their indices;
+	// the equalities and the relations as parsed are not written, only what was built from them
+	void writeSnapshot(SnapshotWriter& writer, const umap<const StructType*, uint32_t>& typeIndices) const;
+	// reads a type written by writeSnapshot into this new type, the types are the ones the indices refer to;
+	// returns false if the data is invalid
+	bool readSnapshot(SnapshotReader& reader, const vec<StructType*>& types);
+	// checks the indices read by readSnapshot against the tables of the other types, once all are read and the members
+	// are checked; returns false if one is out of its range
+	bool checkSnapshot() const;
+
 private:
-	str name;
+	SymbolTable* symbols;
+	Symbol name;
 
-	vec<str> properties;
-	umap<str, PropertyHandle> propertyMap;
+	vec<Symbol> properties;
+	umap<Symbol, PropertyHandle> propertyMap;
 
-	vec<pair<str, StructType*>> members;
-	umap<str, MemberHandle> memberMap;
+	vec<pair<Symbol, StructType*>> members;
+	umap<Symbol, MemberHandle> memberMap;
 
 	vec<pair<DeepMemberHandle, DeepMemberHandle>> memberEqualities;
 
@@ -149,39 +249,89 @@ private:
 	PropertyRelations relations;
 
 	vec<pair<DeepPropertyHandle, const StructType*>> rawPromotions;
-	vec<pair<uint32_t, const StructType*>> promotions;
+	vec<Promotion> promotions;
+
+	vec<Example> examples;
 
 	bool preprocessed = false;
+	uptr<InstanceCircuit> circuit;
+	// counts the assumptions of getPossibleInstancesCount if there is no circuit; built by the first query and kept
+	// with its cache for the lifetime of the type, the queries from different threads take turns on it
+	struct AssumedCounter
+	{
+		std::mutex mutex;
+		uptr<InstanceCounter> counter;
+	};
+	uptr<AssumedCounter> assumedCounter;
+	uptr<ImplicationIndex> implicationIndex;
 
 	vec<vec<uint32_t>> deepMemberGroup;
 	vec<vec<pair<uint32_t, uint32_t>>> deepMemberGroups;
 	vec<StructType*> deepMemberType;
 
-	uint32_t getDeepMemberGroup(const DeepMemberHandle& handle) const;
-	uint32_t getDeepMemberIndex(const DeepMemberHandle& handle) const;
-
-	uint32_t getDeepMemberGroup(const DeepMemberHandle& handle, uint32_t endGroupNumber) const;
-	uint32_t getDeepMemberIndex(const DeepMemberHandle& handle, uint32_t endGroupNumber) const;
-
 	void preprocessMemberEqualities();
 
 	vec<vec<uint32_t>> deepPropertyGroup;
 	vec<vec<pair<uint32_t, uint32_t>>> deepPropertyGroups;
 
-	uint32_t getDeepPropertyIndex(const DeepPropertyHandle& handle) const;
-	uint32_t getDeepPropertyIndex(const DeepMemberHandle& path, uint32_t propertyIndex) const;
-
 	void preprocessPropertyEqualities();
 
+	// The deep member paths interned into a trie, so that a path is resolved by walking its handles without building its tails.
+	// Node 0 is the type itself and the children of a node are the nodes of its members in order. Every node has the maps
+	// from the flat properties and the deep member indices of its type (0 for the node itself, the group + 1 for the others)
+	// to the ones of this type, composed from the tries of the members when the type is preprocessed.
+	struct PathNode
+	{
+		const StructType* type;
+		uint32_t firstChild;
+		uint32_t propertyStart;
+		uint32_t memberStart;
+	};
+	vec<PathNode> pathNodes;
+	vec<uint32_t> pathPropertyIndices;
+	vec<uint32_t> pathMemberIndices;
+
+	void buildPathNodes();
+
+	uint32_t getPathNode(const MemberHandle* path, const size_t length) const
+	{
+		uint32_t node = 0;
+		for (size_t i = 0; i < length; i++)
+			node = pathNodes[node].firstChild + path[i] - 1;
+		return node;
+	}
+
+	uint32_t getPathPropertyIndex(const uint32_t node, const uint32_t propertyIndex) const
+	{
+		return pathPropertyIndices[pathNodes[node].propertyStart + propertyIndex];
+	}
+
+	uint32_t getPathMemberIndex(const uint32_t node, const uint32_t memberIndex) const
+	{
+		return pathMemberIndices[pathNodes[node].memberStart + memberIndex];
+	}
+
 	void checkPromotions(ErrorReporter& er) const;
 
-	vec<vec<FlatProperty>> flatRelations;
+	// the simplified relations, the ones being built are kept as separate clauses until they are simplified
+	ClauseArena flatRelations;
 
-	void preprocessChildPromotions();
+	void preprocessChildPromotions(vec<vec<FlatProperty>>& flat);
 	void preprocessOwnPromotions();
-	void preprocessRelations();
+	void flattenRelation(const vec<DeepProperty>& relation, vec<vec<FlatProperty>>& flat) const;
+	size_t countAssumed(const PartialAssignment& assumptions) const;
+	void preprocessRelations(vec<vec<FlatProperty>>& flat);
+	void simplifyRelations(vec<vec<FlatProperty>>& flat, const SimplificationOptions& options);
+	void preprocessExamples();
 
-	bool checkDeepPropertyValid(const DeepPropertyHandle& handle);
+	SimplificationStats simplificationStats;
 
-	size_t getPossibleInstancesCount(vec<bool> specified, vec<bool> values) const;
+	// the statistics of the members are stored before the ones of the types containing them, so they are summed bottom-up
+	size_t deepPropertyFullCount = 0;
+	size_t deepMemberFullCount = 0;
+	// stored before the threads share the type, so they only read it
+	static constexpr size_t NoCount = std::numeric_limits<size_t>::max();
+	size_t possibleInstancesCount = NoCount;
+
+	bool checkDeepPropertyValid(const DeepPropertyHandle& handle);
 };
\ No newline at end of file
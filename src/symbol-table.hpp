@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string_view>
+
+#include "str.hpp"
+#include "umap.hpp"
+
+typedef uint32_t Symbol;
+
+// Interns the names, so that every distinct name is stored once and the names are compared by their symbols.
+// The names stay in place in the deque, so the map refers to them by views. The symbol 0 is the empty name.
+// Interning is not synchronized, the names are interned while parsing and only read afterwards.
+class SymbolTable
+{
+public:
+	static constexpr Symbol NoSymbol = 0;
+
+	SymbolTable()
+	{
+		names.emplace_back();
+		symbols.emplace(names.front(), NoSymbol);
+	}
+	SymbolTable(const SymbolTable&) = delete;
+	SymbolTable& operator=(const SymbolTable&) = delete;
+
+	Symbol intern(const std::string_view name)
+	{
+		const auto found = symbols.find(name);
+		if (found != symbols.end())
+			return found->second;
+		const Symbol symbol = names.size();
+		names.emplace_back(name);
+		symbols.emplace(names.back(), symbol);
+		return symbol;
+	}
+
+	// returns NoSymbol if the name has not been interned
+	Symbol find(const std::string_view name) const
+	{
+		const auto found = symbols.find(name);
+		return found == symbols.end() ? NoSymbol : found->second;
+	}
+
+	const str& getName(const Symbol symbol) const
+	{
+		return names[symbol];
+	}
+
+	size_t size() const
+	{
+		return names.size();
+	}
+
+private:
+	std::deque<str> names;
+	umap<std::string_view, Symbol> symbols;
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "thread-pool.hpp"
+
+#include <cassert>
+
+namespace
+{
+
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local uint32_t currentWorker = ThreadPool::NoWorker;
+
+}
+
+ThreadPool::ThreadPool(const uint32_t threadCount)
+{
+	assert(threadCount > 0);
+	workers.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+		workers.push_back(make_unique<Worker>());
+	threads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+		threads.push_back(std::thread(&ThreadPool::run, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	uint32_t index = getCurrentWorker();
+	if (index == NoWorker)
+		index = nextWorker++ % workers.size();
+	pending++;
+	{
+		// taken so that a worker cannot miss the notification between checking the queue and going to sleep
+		std::lock_guard<std::mutex> lock(stateMutex);
+		queued++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(workers[index]->mutex);
+		workers[index]->tasks.push_back(std::move(task));
+	}
+	taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	assert(getCurrentWorker() == NoWorker);
+	std::unique_lock<std::mutex> lock(stateMutex);
+	allFinished.wait(lock, [this] { return pending == 0; });
+}
+
+uint32_t ThreadPool::getThreadCount() const
+{
+	return workers.size();
+}
+
+uint32_t ThreadPool::getCurrentWorker() const
+{
+	return currentPool == this ? currentWorker : NoWorker;
+}
+
+uint32_t ThreadPool::getDefaultThreadCount()
+{
+	const uint32_t hardware = std::thread::hardware_concurrency();
+	return hardware ? hardware : 1;
+}
+
+bool ThreadPool::takeTask(const uint32_t index, std::function<void()>& task)
+{
+	{
+		Worker& own = *workers[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			queued--;
+			return true;
+		}
+	}
+	for (uint32_t offset = 1; offset < workers.size(); offset++)
+	{
+		Worker& victim = *workers[(index + offset) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			// the oldest tasks are the largest subtrees
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::run(const uint32_t index)
+{
+	currentPool = this;
+	currentWorker = index;
+	std::function<void()> task;
+	while (true)
+	{
+		if (takeTask(index, task))
+		{
+			task();
+			task = nullptr;
+			if (--pending == 0)
+			{
+				std::lock_guard<std::mutex> lock(stateMutex);
+				allFinished.notify_all();
+			}
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(stateMutex);
+		taskAvailable.wait(lock, [this] { return queued > 0 || stopping; });
+		if (stopping && queued == 0)
+			return;
+	}
+}
\ No newline at end of file
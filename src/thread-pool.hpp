@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "ptr.hpp"
+#include "vec.hpp"
+
+// Work-stealing thread pool. Every worker owns a deque of tasks: it takes its own tasks from the back
+// and steals from the front of the deques of the other workers when its own deque is empty.
+// Tasks submitted from a worker go to the deque of that worker, the other tasks are distributed round-robin.
+class ThreadPool
+{
+public:
+	static constexpr uint32_t NoWorker = std::numeric_limits<uint32_t>::max();
+
+	ThreadPool(uint32_t threadCount);
+	~ThreadPool();
+
+	void submit(std::function<void()> task);
+	// blocks until all the submitted tasks, including the ones submitted by the tasks, are finished
+	void wait();
+
+	uint32_t getThreadCount() const;
+	// the index of the worker of this pool running the calling thread, or NoWorker
+	uint32_t getCurrentWorker() const;
+
+	static uint32_t getDefaultThreadCount();
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	vec<uptr<Worker>> workers;
+	vec<std::thread> threads;
+
+	std::mutex stateMutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable allFinished;
+	std::atomic<size_t> queued{0};
+	std::atomic<size_t> pending{0};
+	std::atomic<uint32_t> nextWorker{0};
+	bool stopping = false;
+
+	bool takeTask(uint32_t index, std::function<void()>& task);
+	void run(uint32_t index);
+};
\ No newline at end of file
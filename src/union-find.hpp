@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "vec.hpp"
+
+// Disjoint sets over the elements 0 .. n - 1 with union by size and path compression, stored in two flat arrays.
+class UnionFind
+{
+public:
+	UnionFind(const uint32_t elementCount) : parents(elementCount), sizes(elementCount, 1)
+	{
+		for (uint32_t element = 0; element < elementCount; element++)
+			parents[element] = element;
+	}
+
+	uint32_t find(uint32_t element)
+	{
+		uint32_t root = element;
+		while (parents[root] != root)
+			root = parents[root];
+		while (parents[element] != root)
+		{
+			const uint32_t parent = parents[element];
+			parents[element] = root;
+			element = parent;
+		}
+		return root;
+	}
+
+	void unite(uint32_t element0, uint32_t element1)
+	{
+		element0 = find(element0);
+		element1 = find(element1);
+		if (element0 == element1)
+			return;
+		if (sizes[element0] < sizes[element1])
+			std::swap(element0, element1);
+		parents[element1] = element0;
+		sizes[element0] += sizes[element1];
+	}
+
+private:
+	vec<uint32_t> parents;
+	vec<uint32_t> sizes;
+};
\ No newline at end of file
@@ -1,16 +1,30 @@
 #include "universe.hpp"
 
-void Universe::addType(const str& name)
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#include "example-validator.hpp"
+#include "mapped-file.hpp"
+#include "snapshot.hpp"
+#include "thread-pool.hpp"
+
+void Universe::addType(const Symbol name)
 {
-	typesOwn.push_back(make_unique<StructType>(name));
+	typesOwn.push_back(make_unique<StructType>(name, *symbols));
 	types[name] = typesOwn.back().get();
 }
 
+StructType* Universe::getType(const Symbol name) const
+{
+	const auto found = types.find(name);
+	return found == types.end() ? nullptr : found->second;
+}
+
 StructType* Universe::getType(const str& name) const
 {
-	if (types.find(name) != types.end())
-		return types.at(name);
-	return nullptr;
+	return getType(symbols->find(name));
 }
 
 const vec<uptr<StructType>>& Universe::getTypes() const
@@ -18,17 +32,252 @@ const vec<uptr<StructType>>& Universe::getTypes() const
 	return typesOwn;
 }
 
+SymbolTable& Universe::getSymbols() const
+{
+	return *symbols;
+}
+
+void Universe::clear()
+{
+	typesOwn.clear();
+	types.clear();
+	snapshotFile.reset();
+}
+
 void Universe::precheck(ErrorReporter& er)
 {
+	vec<vec<StructType*>> waves;
+	getPreprocessWaves(waves, &er);
 	for (const auto& tp : typesOwn)
 		tp->precheck(er);
 }
 
-void Universe::preprocess()
+bool Universe::getPreprocessWaves(vec<vec<StructType*>>& waves, ErrorReporter* er) const
+{
+	struct Frame
+	{
+		uint32_t type;
+		MemberHandle nextMember;
+	};
+	constexpr uint8_t Unvisited = 0;
+	constexpr uint8_t OnStack = 1;
+	constexpr uint8_t Finished = 2;
+
+	umap<const StructType*, uint32_t> typeIndices;
+	for (uint32_t ti = 0; ti < typesOwn.size(); ti++)
+		typeIndices[typesOwn[ti].get()] = ti;
+	vec<uint8_t> states(typesOwn.size(), Unvisited);
+	vec<uint32_t> depths(typesOwn.size(), 0);
+	vec<Frame> stack;
+	bool acyclic = true;
+	// a depth-first search over the members, with an explicit stack so that long member chains cannot overflow
+	for (uint32_t root = 0; root < typesOwn.size(); root++)
+	{
+		if (states[root] != Unvisited)
+			continue;
+		states[root] = OnStack;
+		stack.push_back({ root, 1 });
+		while (!stack.empty())
+		{
+			Frame& frame = stack.back();
+			const StructType& type = *typesOwn[frame.type];
+			if (frame.nextMember > type.getMemberCount())
+			{
+				for (MemberHandle mh = 1; mh <= type.getMemberCount(); mh++)
+					depths[frame.type] = std::max(depths[frame.type], depths[typeIndices.at(type.getMemberType(mh))] + 1);
+				states[frame.type] = Finished;
+				stack.pop_back();
+				continue;
+			}
+			const uint32_t member = typeIndices.at(type.getMemberType(frame.nextMember++));
+			if (states[member] == Unvisited)
+			{
+				states[member] = OnStack;
+				stack.push_back({ member, 1 });
+			}
+			else if (states[member] == OnStack)
+			{
+				acyclic = false;
+				if (!er)
+					continue;
+				uint32_t si = 0;
+				while (stack[si].type != member)
+					si++;
+				str path;
+				for (; si < stack.size(); si++)
+					path += (path.empty() ? "" : ".") + typesOwn[stack[si].type]->getMemberName(stack[si].nextMember - 1);
+				er->reportProc("Type " + typesOwn[member]->getName() + " contains itself through its members " + path + ".");
+			}
+		}
+	}
+	if (!acyclic)
+		return false;
+	for (uint32_t ti = 0; ti < typesOwn.size(); ti++)
+	{
+		if (depths[ti] >= waves.size())
+			waves.resize(depths[ti] + 1);
+		waves[depths[ti]].push_back(typesOwn[ti].get());
+	}
+	return true;
+}
+
+void Universe::preprocess(const SimplificationOptions& options, const uint32_t threadCount)
+{
+	vec<vec<StructType*>> waves;
+	const bool acyclic = getPreprocessWaves(waves, nullptr);
+	assert(acyclic);
+	(void)acyclic;
+	if (threadCount <= 1)
+	{
+		for (const vec<StructType*>& wave : waves)
+		{
+			for (StructType* const tp : wave)
+			{
+				if (!tp->isPreprocessed())
+					tp->preprocess(options);
+			}
+		}
+		return;
+	}
+	// a type only reads its members, which are in the earlier waves, and writes the maps of the promotions to itself
+	ThreadPool pool(threadCount);
+	for (const vec<StructType*>& wave : waves)
+	{
+		for (StructType* const tp : wave)
+		{
+			if (!tp->isPreprocessed())
+				pool.submit([tp, &options]() { tp->preprocess(options); });
+		}
+		pool.wait();
+	}
+}
+
+void Universe::compile()
 {
 	for (const auto& tp : typesOwn)
 	{
-		if (!tp->isPreprocessed())
-			tp->preprocess();
+		if (!tp->isCompiled())
+			tp->compile();
+	}
+	// the circuits of the promotion targets are queried as well, so the counts are stored once all are compiled
+	for (const auto& tp : typesOwn)
+		tp->storePossibleInstancesCount();
+}
+
+void Universe::buildImplicationIndices()
+{
+	for (const auto& tp : typesOwn)
+	{
+		if (!tp->getImplicationIndex())
+			tp->buildImplicationIndex();
+	}
+}
+
+vec<StructType*> Universe::resetDependents(const vec<StructType*>& changed)
+{
+	vec<uint8_t> affected(typesOwn.size(), 0);
+	for (uint32_t ti = 0; ti < typesOwn.size(); ti++)
+		affected[ti] = std::find(changed.begin(), changed.end(), typesOwn[ti].get()) != changed.end();
+	// the dependents are collected to a fixpoint before anything is reset, since the dependencies are lost by a reset
+	bool grown = true;
+	while (grown)
+	{
+		grown = false;
+		for (uint32_t ti = 0; ti < typesOwn.size(); ti++)
+		{
+			for (uint32_t di = 0; di < typesOwn.size() && !affected[ti]; di++)
+			{
+				if (affected[di] && typesOwn[ti]->dependsOn(typesOwn[di].get()))
+					affected[ti] = grown = true;
+			}
+		}
+	}
+	vec<StructType*> reset;
+	for (uint32_t ti = 0; ti < typesOwn.size(); ti++)
+	{
+		if (!affected[ti])
+			continue;
+		typesOwn[ti]->reset();
+		reset.push_back(typesOwn[ti].get());
+	}
+	return reset;
+}
+
+size_t Universe::checkExamples(ErrorReporter& er) const
+{
+	size_t inconsistent = 0;
+	for (const auto& tp : typesOwn)
+		inconsistent += ExampleValidator(*tp).validate(er);
+	return inconsistent;
+}
+
+static constexpr char SnapshotMagic[4] = { 'S', 'U', 'N', 'I' };
+static constexpr uint32_t SnapshotVersion = 3;
+
+bool Universe::saveSnapshot(const str& path) const
+{
+	std::ofstream output(path, std::ios::binary);
+	if (!output)
+		return false;
+	umap<const StructType*, uint32_t> typeIndices;
+	for (uint32_t ti = 0; ti < typesOwn.size(); ti++)
+		typeIndices[typesOwn[ti].get()] = ti;
+	SnapshotWriter writer(output);
+	output.write(SnapshotMagic, 4);
+	writer.writeWord(SnapshotVersion);
+	// the names first, so that the types can refer to the ones after them
+	writer.writeWord(typesOwn.size());
+	for (const auto& tp : typesOwn)
+		writer.writeString(tp->getName());
+	for (const auto& tp : typesOwn)
+		tp->writeSnapshot(writer, typeIndices);
+	return bool(output.flush());
+}
+
+bool Universe::loadSnapshot(const str& path)
+{
+	clear();
+	snapshotFile = make_unique<MappedFile>(path);
+	const MappedFile& file = *snapshotFile;
+	if (!file.isOpen() || file.getSize() < 8 || std::memcmp(file.getData(), SnapshotMagic, 4))
+	{
+		snapshotFile.reset();
+		return false;
+	}
+	SnapshotReader reader(file.getData() + 4, file.getSize() - 4);
+	if (reader.readWord() != SnapshotVersion)
+		return false;
+	for (uint32_t ti = reader.readLength(1); ti > 0 && reader.isValid(); ti--)
+	{
+		const Symbol name = symbols->intern(reader.readString());
+		if (getType(name))
+			reader.invalidate();
+		else
+			addType(name);
+	}
+	vec<StructType*> loaded;
+	for (const auto& tp : typesOwn)
+		loaded.push_back(tp.get());
+	for (StructType* const tp : loaded)
+	{
+		if (!reader.isValid() || !tp->readSnapshot(reader, loaded))
+			break;
+	}
+	// the types refer to the tables of their members and promotion targets, which may come after them in the file,
+	// so they are checked once all are read, the members first, and the types containing themselves are rejected
+	vec<vec<StructType*>> waves;
+	if (reader.isValid() && !getPreprocessWaves(waves, nullptr))
+		reader.invalidate();
+	for (const vec<StructType*>& wave : waves)
+	{
+		for (const StructType* const tp : wave)
+		{
+			if (reader.isValid() && !tp->checkSnapshot())
+				reader.invalidate();
+		}
 	}
+	if (reader.isValid() && reader.isAtEnd())
+		return true;
+	clear();
+	return false;
 }
\ No newline at end of file
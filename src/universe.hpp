@@ -2,8 +2,10 @@
 
 #include <unordered_map>
 
+#include "mapped-file.hpp"
 #include "ptr.hpp"
 #include "str.hpp"
+#include "symbol-table.hpp"
 #include "umap.hpp"
 #include "vec.hpp"
 
@@ -12,15 +14,47 @@
 class Universe
 {
 public:
-	void addType(const str& name);
+	void addType(Symbol name);
 
 	// returns nullptr if such type doesn't exist
+	StructType* getType(Symbol name) const;
 	StructType* getType(const str& name) const;
 	const vec<uptr<StructType>>& getTypes() const;
+	// the names of the types and of their properties and members, kept when the types are cleared
+	SymbolTable& getSymbols() const;
+	// drops all the types, the symbols stay valid
+	void clear();
 
+	// reports the types that contain themselves through their members and the invalid promotions
 	void precheck(ErrorReporter& er);
-	void preprocess();
+	// preprocesses the types in waves, every type after the types of its members, the types of a wave concurrently;
+	// the members must not be cyclic
+	void preprocess(const SimplificationOptions& options = SimplificationOptions(), uint32_t threadCount = 1);
+	// builds the counting circuits of all the types, must follow preprocess
+	void compile();
+	// reports the examples inconsistent with the relations of their types and returns their number, must follow preprocess
+	size_t checkExamples(ErrorReporter& er) const;
+	// builds the implication indices of all the types, must follow preprocess
+	void buildImplicationIndices();
+	// resets the types and the types that depend on them through their members and promotions,
+	// returns all the types reset in the order of the universe
+	vec<StructType*> resetDependents(const vec<StructType*>& changed);
+
+	// writes the preprocessed types to a versioned binary file in which the types refer to each other by their indices,
+	// returns false if the file cannot be written
+	bool saveSnapshot(const str& path) const;
+	// replaces the types with the preprocessed types of the snapshot, mapped read-only, so loading only copies the tables
+	// and the relations stay in the mapped pages, shared by the processes loading the same file;
+	// returns false and leaves the universe empty if the file cannot be read or is invalid
+	bool loadSnapshot(const str& path);
 private:
+	// the table is held by a pointer, since the types refer to it and the universe may be moved
+	uptr<SymbolTable> symbols = make_unique<SymbolTable>();
+	// the loaded snapshot, the relations of its types refer to it, so it is released after them
+	uptr<MappedFile> snapshotFile;
 	vec<uptr<StructType>> typesOwn;
-	umap<str, StructType*> types;
+
+	// groups the types by the length of their longest member chain, returns false (and reports if er is given) if a type contains itself
+	bool getPreprocessWaves(vec<vec<StructType*>>& waves, ErrorReporter* er) const;
+	umap<Symbol, StructType*> types;
 };
\ No newline at end of file